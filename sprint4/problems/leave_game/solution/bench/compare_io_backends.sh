@@ -0,0 +1,128 @@
+#!/bin/bash
+# Сравнение бэкендов ввода-вывода game_server: epoll и io_uring (GAME_SERVER_IO_URING).
+#
+# Собирает обе версии сервера и load_generator, по очереди запускает сервер под одной
+# и той же нагрузкой и для каждого бэкенда сохраняет в OUT_DIR:
+#   load.txt    — таблицу задержек load_generator (p50…max на стороне клиента);
+#   strace.txt  — число системных вызовов за время нагрузки (strace -c);
+#   metrics.txt — /api/v1/admin/metrics после нагрузки.
+# Снимок состояния пишется раз в секунду, чтобы в сравнение попала и файловая запись.
+# В конце печатает сводку: rps, p99 клиента, p99 сервера по гистограмме и число syscalls.
+#
+# Нужны conan 1.x, cmake, strace, curl, liburing и переменная GAME_DB_URL.
+# Параметры задаются переменными окружения, ниже — значения по умолчанию.
+
+set -euo pipefail
+
+SOLUTION=$(cd "$(dirname "$0")/.." && pwd -P)
+
+IO_CONTEXTS=${IO_CONTEXTS:-$(nproc)}
+TICK_PERIOD=${TICK_PERIOD:-50}
+PLAYERS=${PLAYERS:-1000}
+CONNECTIONS=${CONNECTIONS:-64}
+RPS=${RPS:-20000}
+DURATION=${DURATION:-30}
+MIX=${MIX:-action=55,state=30,players=5,records=5,maps=5}
+PORT=8080
+OUT_DIR=${OUT_DIR:-${SOLUTION}/bench/results}
+
+if [ -z "${GAME_DB_URL:-}" ]; then
+    echo "GAME_DB_URL is not set" >&2
+    exit 1
+fi
+
+# build_backend <каталог сборки> <флаги cmake...>
+function build_backend() {
+    local build_dir=$1
+    shift
+    mkdir -p "${build_dir}"
+    if [ ! -f "${build_dir}/conanbuildinfo_multi.cmake" ]; then
+        (cd "${build_dir}" && conan install "${SOLUTION}" --build=missing -s build_type=Release \
+            -s compiler.libcxx=libstdc++11)
+    fi
+    cmake -S "${SOLUTION}" -B "${build_dir}" -DCMAKE_BUILD_TYPE=Release "$@"
+    cmake --build "${build_dir}" --target game_server load_generator -j"$(nproc)"
+}
+
+function wait_for_port() {
+    for _ in $(seq 100); do
+        if curl -sf "http://127.0.0.1:${PORT}/api/v1/maps" >/dev/null; then
+            return 0
+        fi
+        sleep 0.1
+    done
+    echo "game_server did not start" >&2
+    return 1
+}
+
+# p99 по сумме гистограмм game_http_request_duration_seconds всех маршрутов, в миллисекундах.
+# Корзины накопительные и у всех маршрутов одинаковые, поэтому их можно сложить по границе le
+function server_p99_ms() {
+    sed -nE 's/^game_http_request_duration_seconds_bucket\{.*le="([^"]*)"\} ([0-9]+)$/\1 \2/p' "$1" |
+        awk '{ count[$1] += $2 } END { for (le in count) print le, count[le] }' |
+        sort -g |
+        awk '{ le[NR] = $1; count[NR] = $2 }
+             END {
+                 for (i = 1; i <= NR; ++i) {
+                     if (count[i] >= 0.99 * count[NR]) {
+                         if (le[i] == "+Inf") print "+Inf"; else printf "%.3f\n", le[i] * 1000;
+                         exit
+                     }
+                 }
+                 print "n/a"
+             }'
+}
+
+# Сумма столбца calls по строкам отдельных вызовов: в них всегда есть usecs/call, и calls — четвёртый
+function syscall_count() {
+    awk '/^-+/ { ++separators; next } separators == 1 { calls += $4 } END { print calls + 0 }' "$1"
+}
+
+# run_backend <имя> <каталог сборки> <дополнительные флаги сервера...>
+function run_backend() {
+    local name=$1 build_dir=$2
+    shift 2
+    local out="${OUT_DIR}/${name}"
+    mkdir -p "${out}"
+
+    "${build_dir}/game_server" --config-file "${SOLUTION}/data/config.json" --www-root "${SOLUTION}/static" \
+        --tick-period "${TICK_PERIOD}" --io-contexts "${IO_CONTEXTS}" --log-sample 0 \
+        --state-file "${out}/state.bin" --save-state-period 1000 "$@" \
+        >"${out}/server.log" 2>&1 &
+    local server_pid=$!
+    trap 'kill ${server_pid} 2>/dev/null || true' EXIT
+    wait_for_port
+
+    strace -c -f -o "${out}/strace.txt" -p "${server_pid}" &
+    local strace_pid=$!
+
+    "${build_dir}/load_generator" --port "${PORT}" --players "${PLAYERS}" --connections "${CONNECTIONS}" \
+        --rps "${RPS}" --duration "${DURATION}" --mix "${MIX}" | tee "${out}/load.txt"
+
+    kill -INT "${strace_pid}"
+    wait "${strace_pid}" || true
+    curl -sf "http://127.0.0.1:${PORT}/api/v1/admin/metrics" >"${out}/metrics.txt"
+
+    kill -INT "${server_pid}"
+    wait "${server_pid}" || true
+    trap - EXIT
+}
+
+function summary_line() {
+    local name=$1 out="${OUT_DIR}/$1"
+    local rps p99 syscalls
+    rps=$(awk '$1 == "total" { print $4 }' "${out}/load.txt")
+    p99=$(awk '$1 == "total" { print $7 }' "${out}/load.txt")
+    syscalls=$(syscall_count "${out}/strace.txt")
+    printf "%-10s %10s %14s %14s %12s\n" "${name}" "${rps}" "${p99}" "$(server_p99_ms "${out}/metrics.txt")" "${syscalls}"
+}
+
+build_backend "${SOLUTION}/build-epoll"
+build_backend "${SOLUTION}/build-io-uring" -DGAME_SERVER_IO_URING=ON
+
+run_backend epoll "${SOLUTION}/build-epoll"
+run_backend io_uring "${SOLUTION}/build-io-uring" --io-uring
+
+printf "\n%-10s %10s %14s %14s %12s\n" "backend" "rps" "client p99,ms" "server p99,ms" "syscalls"
+summary_line epoll
+summary_line io_uring
@@ -0,0 +1,207 @@
+#pragma once
+
+#include <boost/beast/http/verb.hpp>
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+namespace api_router
+{
+
+    using namespace std::literals;
+
+    enum class Endpoint : uint8_t
+    {
+        MAPS,
+        MAP_BY_ID,
+        JOIN,
+        PLAYERS,
+        STATE,
+        ACTION,
+        ACTIONS,
+        TICK,
+        RECORDS,
+        METRICS
+    };
+
+    inline constexpr size_t ENDPOINT_COUNT = static_cast<size_t>(Endpoint::METRICS) + 1;
+
+    // Допустимые методы хранятся битовой маской
+    enum MethodMask : uint8_t
+    {
+        METHOD_GET = 1,
+        METHOD_HEAD = 2,
+        METHOD_POST = 4
+    };
+
+    constexpr uint8_t ToMethodMask(boost::beast::http::verb method) noexcept
+    {
+        switch (method)
+        {
+        case boost::beast::http::verb::get:
+            return METHOD_GET;
+        case boost::beast::http::verb::head:
+            return METHOD_HEAD;
+        case boost::beast::http::verb::post:
+            return METHOD_POST;
+        default:
+            return 0;
+        }
+    }
+
+    // Где выполняется обработчик маршрута
+    enum class Runner : uint8_t
+    {
+        // Сразу в потоке ввода-вывода сессии: не трогает состояние игры
+        IO,
+        // В strand игры: меняет или читает состояние игры
+        STRAND,
+        // В пуле блокирующих задач: ждёт базу данных, ответ уходит в исполнитель сессии
+        BLOCKING,
+    };
+
+    struct Route
+    {
+        // Путь относительно API_PREFIX. Путь с завершающим '/' — префиксный:
+        // остаток цели запроса передаётся обработчику как параметр (id карты)
+        std::string_view path;
+        Endpoint endpoint;
+        uint8_t methods;
+        Runner runner;
+        // Значение заголовка Allow для ответа 405
+        std::string_view allow;
+        // Сообщение ответа 405: у эндпоинтов оно исторически разное
+        std::string_view method_error;
+
+        constexpr bool IsPrefix() const noexcept
+        {
+            return !path.empty() && path.back() == '/';
+        }
+
+        constexpr bool Allows(boost::beast::http::verb method) const noexcept
+        {
+            return (methods & ToMethodMask(method)) != 0;
+        }
+    };
+
+    inline constexpr std::string_view API_PREFIX = "/api/v1/"sv;
+
+    // Таблица маршрутов. Должна быть отсортирована по path — это проверяется при компиляции
+    inline constexpr auto ROUTES = std::to_array<Route>({
+        {"admin/metrics"sv, Endpoint::METRICS, METHOD_GET | METHOD_HEAD, Runner::IO, "GET, HEAD"sv, "Invalid method"sv},
+        {"game/join"sv, Endpoint::JOIN, METHOD_POST, Runner::STRAND, "POST"sv, "Only POST method is expected"sv},
+        {"game/player/action"sv, Endpoint::ACTION, METHOD_POST, Runner::STRAND, "POST"sv, "Invalid method"sv},
+        {"game/player/actions"sv, Endpoint::ACTIONS, METHOD_POST, Runner::STRAND, "POST"sv, "Invalid method"sv},
+        {"game/players"sv, Endpoint::PLAYERS, METHOD_GET | METHOD_HEAD, Runner::STRAND, "GET, HEAD"sv, "Invalid method"sv},
+        {"game/records"sv, Endpoint::RECORDS, METHOD_GET, Runner::BLOCKING, "GET"sv, "Only GET method is allowed"sv},
+        {"game/state"sv, Endpoint::STATE, METHOD_GET | METHOD_HEAD, Runner::STRAND, "GET, HEAD"sv, "Invalid method"sv},
+        {"game/tick"sv, Endpoint::TICK, METHOD_POST, Runner::STRAND, "POST"sv, "Only POST method is expected"sv},
+        {"maps"sv, Endpoint::MAPS, METHOD_GET | METHOD_HEAD, Runner::IO, "GET, HEAD"sv, "Only GET, HEAD method supported"sv},
+        {"maps/"sv, Endpoint::MAP_BY_ID, METHOD_GET | METHOD_HEAD, Runner::IO, "GET, HEAD"sv, "Only GET, HEAD method supported"sv},
+    });
+
+    static_assert(std::is_sorted(ROUTES.begin(), ROUTES.end(), [](const Route &lhs, const Route &rhs)
+                                 { return lhs.path < rhs.path; }),
+                  "ROUTES must be sorted by path");
+
+    struct RouteMatch
+    {
+        const Route *route = nullptr;
+        // Остаток пути для префиксного маршрута
+        std::string_view param;
+        // Строка запроса без '?'
+        std::string_view query;
+
+        constexpr explicit operator bool() const noexcept
+        {
+            return route != nullptr;
+        }
+    };
+
+    constexpr const Route *FindRoute(std::string_view path) noexcept
+    {
+        auto it = std::lower_bound(ROUTES.begin(), ROUTES.end(), path, [](const Route &route, std::string_view value)
+                                   { return route.path < value; });
+        return it != ROUTES.end() && it->path == path ? &*it : nullptr;
+    }
+
+    // Разбирает цель запроса за один проход без выделения памяти.
+    // Возвращаемые string_view ссылаются на target.
+    constexpr RouteMatch Match(std::string_view target) noexcept
+    {
+        RouteMatch match;
+        if (const auto pos = target.find('?'); pos != std::string_view::npos)
+        {
+            match.query = target.substr(pos + 1);
+            target = target.substr(0, pos);
+        }
+        if (!target.starts_with(API_PREFIX))
+        {
+            return match;
+        }
+        const std::string_view path = target.substr(API_PREFIX.size());
+        if (const Route *route = FindRoute(path))
+        {
+            match.route = route;
+            return match;
+        }
+        if (const auto slash = path.rfind('/'); slash != std::string_view::npos)
+        {
+            const Route *route = FindRoute(path.substr(0, slash + 1));
+            if (route && route->IsPrefix())
+            {
+                match.route = route;
+                match.param = path.substr(slash + 1);
+            }
+        }
+        return match;
+    }
+
+    // Ищет значение параметра в строке запроса вида a=1&b=2
+    constexpr std::optional<std::string_view> FindQueryParam(std::string_view query, std::string_view name) noexcept
+    {
+        while (!query.empty())
+        {
+            const auto amp = query.find('&');
+            const std::string_view pair = query.substr(0, amp);
+            const auto eq = pair.find('=');
+            if (eq != std::string_view::npos && pair.substr(0, eq) == name)
+            {
+                return pair.substr(eq + 1);
+            }
+            if (amp == std::string_view::npos)
+            {
+                break;
+            }
+            query.remove_prefix(amp + 1);
+        }
+        return std::nullopt;
+    }
+
+    // Возвращает false, если значение не является целым числом без знака
+    template <typename T>
+    bool ParseUnsigned(std::string_view str, T &value) noexcept
+    {
+        const auto [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(), value);
+        return ec == std::errc{} && ptr == str.data() + str.size();
+    }
+
+    // Возвращает false, если значение не является конечным числом
+    inline bool ParseDouble(std::string_view str, double &value) noexcept
+    {
+        const auto [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(), value);
+        return ec == std::errc{} && ptr == str.data() + str.size() && std::isfinite(value);
+    }
+
+    static_assert(Match("/api/v1/maps"sv).route->endpoint == Endpoint::MAPS);
+    static_assert(Match("/api/v1/maps/map1"sv).param == "map1"sv);
+    static_assert(Match("/api/v1/game/records?start=1"sv).query == "start=1"sv);
+    static_assert(!Match("/api/v1/game/joinx"sv));
+    static_assert(Match("/api/v1/game/player/actions"sv).route->endpoint == Endpoint::ACTIONS);
+
+} // namespace api_router
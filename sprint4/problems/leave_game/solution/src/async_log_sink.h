@@ -0,0 +1,257 @@
+#pragma once
+
+#include <boost/log/core/record_view.hpp>
+#include <boost/log/sinks/basic_sink_backend.hpp>
+#include <boost/log/sinks/frontend_requirements.hpp>
+#include <boost/log/trivial.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace async_log
+{
+
+    struct SinkSettings
+    {
+        boost::log::trivial::severity_level min_level = boost::log::trivial::info;
+        // Логируется каждый N-й запрос (1 — все, 0 — ни одного)
+        unsigned sample_every = 1;
+        size_t queue_capacity = 1 << 16;
+        size_t batch_size = 256;
+    };
+
+    // Ограниченная lock-free очередь (схема Д. Вьюкова).
+    // Класть элементы могут любые потоки, забирает только поток записи.
+    template <typename T>
+    class MpscRing
+    {
+    public:
+        explicit MpscRing(size_t capacity)
+        {
+            size_t size = 2;
+            while (size < capacity)
+            {
+                size <<= 1;
+            }
+            mask_ = size - 1;
+            cells_ = std::make_unique<Cell[]>(size);
+            for (size_t i = 0; i < size; ++i)
+            {
+                cells_[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        MpscRing(const MpscRing &) = delete;
+        MpscRing &operator=(const MpscRing &) = delete;
+
+        // Возвращает false, если очередь заполнена
+        bool TryPush(T &&value)
+        {
+            Cell *cell = nullptr;
+            size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                cell = &cells_[pos & mask_];
+                const size_t seq = cell->sequence.load(std::memory_order_acquire);
+                const auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+                if (diff == 0)
+                {
+                    if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    {
+                        break;
+                    }
+                }
+                else if (diff < 0)
+                {
+                    return false;
+                }
+                else
+                {
+                    pos = enqueue_pos_.load(std::memory_order_relaxed);
+                }
+            }
+            cell->value = std::move(value);
+            cell->sequence.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Вызывается только из одного потока-потребителя
+        bool TryPop(T &value)
+        {
+            Cell &cell = cells_[dequeue_pos_ & mask_];
+            const size_t seq = cell.sequence.load(std::memory_order_acquire);
+            if (static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(dequeue_pos_ + 1) < 0)
+            {
+                return false;
+            }
+            value = std::move(cell.value);
+            cell.sequence.store(dequeue_pos_ + mask_ + 1, std::memory_order_release);
+            ++dequeue_pos_;
+            return true;
+        }
+
+    private:
+        struct Cell
+        {
+            std::atomic<size_t> sequence;
+            T value;
+        };
+
+        std::unique_ptr<Cell[]> cells_;
+        size_t mask_ = 0;
+        alignas(64) std::atomic<size_t> enqueue_pos_{0};
+        alignas(64) size_t dequeue_pos_ = 0;
+    };
+
+    // Бэкенд Boost.Log: отформатированные строки складываются в кольцо,
+    // а отдельный поток пишет их в файл пачками. Потоки io_context
+    // не блокируются ни на мьютексе синка, ни на записи в консоль.
+    // При переполнении очереди запись отбрасывается и учитывается в счётчике.
+    class AsyncLineBackend
+        : public boost::log::sinks::basic_formatted_sink_backend<char, boost::log::sinks::concurrent_feeding>
+    {
+    public:
+        AsyncLineBackend(std::FILE *out, size_t queue_capacity, size_t batch_size)
+            : out_{out}, batch_size_{std::max<size_t>(batch_size, 1)}, ring_{queue_capacity}
+        {
+            writer_ = std::thread([this]
+                                  { Run(); });
+        }
+
+        ~AsyncLineBackend()
+        {
+            Stop();
+        }
+
+        void consume(const boost::log::record_view &, const string_type &line)
+        {
+            if (ring_.TryPush(std::string(line)))
+            {
+                pushed_.fetch_add(1, std::memory_order_seq_cst);
+                // Будим поток записи, только если он уснул на пустой очереди
+                if (sleeping_.load(std::memory_order_seq_cst))
+                {
+                    Wake();
+                }
+            }
+            else
+            {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        // Дожидается, пока всё, что уже попало в очередь, будет записано
+        void flush()
+        {
+            const uint64_t target = pushed_.load(std::memory_order_acquire);
+            while (written_.load(std::memory_order_acquire) < target && writer_.joinable())
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+
+        void Stop()
+        {
+            if (writer_.joinable())
+            {
+                running_.store(false, std::memory_order_seq_cst);
+                Wake();
+                writer_.join();
+            }
+        }
+
+        uint64_t GetDroppedCount() const
+        {
+            return dropped_.load(std::memory_order_relaxed);
+        }
+
+    private:
+        void Wake()
+        {
+            wakeups_.fetch_add(1, std::memory_order_seq_cst);
+            wakeups_.notify_one();
+        }
+
+        void Run()
+        {
+            std::string batch;
+            std::string line;
+            for (;;)
+            {
+                // Значения читаются до разбора очереди: всё, что придёт позже, изменит хотя бы одно из них
+                const uint32_t wakeups = wakeups_.load(std::memory_order_seq_cst);
+                const uint64_t pushed = pushed_.load(std::memory_order_seq_cst);
+                const bool stopping = !running_.load(std::memory_order_seq_cst);
+                size_t count = 0;
+                while (count < batch_size_ && ring_.TryPop(line))
+                {
+                    batch += line;
+                    batch += '\n';
+                    ++count;
+                }
+                if (count > 0)
+                {
+                    std::fwrite(batch.data(), 1, batch.size(), out_);
+                    std::fflush(out_);
+                    batch.clear();
+                    written_.fetch_add(count, std::memory_order_release);
+                    continue;
+                }
+                if (stopping)
+                {
+                    break;
+                }
+                // Очередь пуста: спим до Wake. Запись, добавленная после проверки pushed_,
+                // увидит sleeping_ и изменит wakeups_, поэтому wait сразу вернётся
+                sleeping_.store(true, std::memory_order_seq_cst);
+                if (pushed_.load(std::memory_order_seq_cst) == pushed)
+                {
+                    wakeups_.wait(wakeups, std::memory_order_seq_cst);
+                }
+                sleeping_.store(false, std::memory_order_relaxed);
+            }
+        }
+
+        std::FILE *out_;
+        size_t batch_size_;
+        MpscRing<std::string> ring_;
+        std::atomic<bool> running_{true};
+        std::atomic<uint64_t> pushed_{0};
+        std::atomic<uint64_t> written_{0};
+        std::atomic<uint64_t> dropped_{0};
+        std::atomic<bool> sleeping_{false};
+        std::atomic<uint32_t> wakeups_{0};
+        std::thread writer_;
+    };
+
+    // Выборка каждого N-го события. Счётчик свой у каждого потока,
+    // поэтому общих атомиков на горячем пути нет.
+    class Sampler
+    {
+    public:
+        explicit Sampler(unsigned every = 1) noexcept
+            : every_{every}
+        {
+        }
+
+        bool Take() const noexcept
+        {
+            if (every_ <= 1)
+            {
+                return every_ == 1;
+            }
+            thread_local unsigned counter = 0;
+            return counter++ % every_ == 0;
+        }
+
+    private:
+        unsigned every_;
+    };
+
+} // namespace async_log
@@ -0,0 +1,233 @@
+#pragma once
+
+#include "objects.h"
+#include "fast_random.h"
+#include "timer_wheel.h"
+
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace bots
+{
+
+    // Поведение ботов: WANDER ходит в случайных направлениях,
+    // COLLECT идёт к ближайшему из нескольких трофеев, а с полным рюкзаком — к офису
+    enum class Policy
+    {
+        WANDER,
+        COLLECT
+    };
+
+    inline std::optional<Policy> ParsePolicy(std::string_view name)
+    {
+        if (name == "wander")
+        {
+            return Policy::WANDER;
+        }
+        if (name == "collect")
+        {
+            return Policy::COLLECT;
+        }
+        return std::nullopt;
+    }
+
+    struct Settings
+    {
+        // Сколько ботов держать на каждой карте, 0 — ботов нет
+        size_t bots_per_map = 0;
+        Policy policy = Policy::WANDER;
+    };
+
+    // Собака бота и сессия, в которую она попала
+    struct Joined
+    {
+        std::shared_ptr<GameSession> session;
+        std::shared_ptr<Dog> dog;
+    };
+
+    /*
+     *  Боты управляют собаками так же, как игроки через /game/player/action,
+     *  но без HTTP: Act вызывается в strand в начале тика.
+     *  Решения ботов назначаются в колесе таймеров, поэтому тик стоит
+     *  пропорционально числу решений, а не числу ботов.
+     *  Иногда бот бросает собаку: она уходит на покой, результат попадает
+     *  в таблицу рекордов, а на её место приходит новый бот.
+     */
+    class BotPopulation
+    {
+    public:
+        // join(map_index, name) добавляет в игру игрока с собакой на карте map_index
+        using JoinFn = std::function<Joined(size_t map_index, std::string_view name)>;
+
+        BotPopulation(Settings settings, size_t map_count, JoinFn join, uint64_t seed = util::FastRandom{}())
+            : settings_(settings), join_(std::move(join)), random_(seed)
+        {
+            bots_.reserve(settings_.bots_per_map * map_count);
+            for (size_t map_index = 0; map_index < map_count; ++map_index)
+            {
+                for (size_t i = 0; i < settings_.bots_per_map; ++i)
+                {
+                    // Боты заходят в игру на первом тике
+                    decisions_.Schedule(0, static_cast<uint32_t>(bots_.size()));
+                    bots_.emplace_back(map_index);
+                }
+            }
+        }
+
+        size_t size() const { return bots_.size(); }
+
+        // Решения, срок которых наступает за тик длительностью delta
+        void Act(std::chrono::milliseconds delta)
+        {
+            decisions_.Advance(decisions_.GetTime() + static_cast<uint64_t>(delta.count()),
+                               [this](uint32_t index, uint64_t)
+                               { Decide(index); });
+        }
+
+    private:
+        // Интервал между решениями бота, мс
+        static constexpr uint64_t WANDER_PERIOD_MIN_MS = 1000;
+        static constexpr uint64_t WANDER_PERIOD_MAX_MS = 4000;
+        static constexpr uint64_t COLLECT_PERIOD_MIN_MS = 300;
+        static constexpr uint64_t COLLECT_PERIOD_MAX_MS = 1000;
+        // Вероятность, что при очередном решении бот бросит собаку
+        static constexpr double ABANDON_CHANCE = 0.01;
+        // Из скольких случайных трофеев COLLECT выбирает ближайший
+        static constexpr size_t COLLECT_SAMPLES = 16;
+        // Ближе этого по оси цель считается достигнутой
+        static constexpr double AXIS_EPSILON = 0.4;
+
+        struct Bot
+        {
+            explicit Bot(size_t map_index)
+                : map_index(map_index)
+            {
+            }
+
+            size_t map_index;
+            // Сессия объявлена раньше собаки: weak_ptr на собаку не должен её пережить
+            std::shared_ptr<GameSession> session;
+            std::weak_ptr<Dog> dog;
+            model::Position last_pos{-1.0, -1.0};
+            bool abandoned = false;
+        };
+
+        Settings settings_;
+        JoinFn join_;
+        util::FastRandom random_;
+        std::vector<Bot> bots_;
+        util::TimerWheel<uint32_t> decisions_;
+        uint64_t next_bot_number_ = 0;
+
+        void Decide(uint32_t index)
+        {
+            Bot &bot = bots_[index];
+            std::shared_ptr<Dog> dog = bot.dog.lock();
+            if (!dog || dog->IsRetired())
+            {
+                Joined joined = join_(bot.map_index, "bot" + std::to_string(next_bot_number_++));
+                // Сначала собака: блок управления старого weak_ptr лежит в памяти старой сессии,
+                // а бот может держать последнюю ссылку на уже убранный экземпляр
+                bot.dog = joined.dog;
+                bot.session = std::move(joined.session);
+                bot.abandoned = false;
+                dog = std::move(joined.dog);
+                bot.last_pos = {-1.0, -1.0};
+            }
+            if (bot.abandoned)
+            {
+                // Брошенная собака уйдёт сама, её место займёт новый бот
+                Schedule(index, WANDER_PERIOD_MIN_MS);
+                return;
+            }
+            if (random_.NextDouble() < ABANDON_CHANCE)
+            {
+                bot.abandoned = true;
+                bot.session->SteerDog(dog, dog->GetDirection(), 0.0);
+                Schedule(index, static_cast<uint64_t>(dog->GetRetirementTimeout() * 1000.0));
+                return;
+            }
+
+            const bool stuck = dog->GetPosition() == bot.last_pos;
+            bot.last_pos = dog->GetPosition();
+            const double speed = bot.session->GetMap()->GetSpeedForThisMap();
+            if (settings_.policy == Policy::COLLECT && !stuck)
+            {
+                if (const auto target = PickTarget(*bot.session, *dog))
+                {
+                    bot.session->SteerDog(dog, DirectionTo(dog->GetPosition(), *target), speed);
+                    Schedule(index, RandomPeriod(COLLECT_PERIOD_MIN_MS, COLLECT_PERIOD_MAX_MS));
+                    return;
+                }
+            }
+            bot.session->SteerDog(dog, static_cast<Direction>(random_() % 4), speed);
+            Schedule(index, settings_.policy == Policy::COLLECT
+                                ? RandomPeriod(COLLECT_PERIOD_MIN_MS, COLLECT_PERIOD_MAX_MS)
+                                : RandomPeriod(WANDER_PERIOD_MIN_MS, WANDER_PERIOD_MAX_MS));
+        }
+
+        void Schedule(uint32_t index, uint64_t after_ms)
+        {
+            decisions_.Schedule(decisions_.GetTime() + after_ms, index);
+        }
+        uint64_t RandomPeriod(uint64_t min_ms, uint64_t max_ms)
+        {
+            return min_ms + random_() % (max_ms - min_ms + 1);
+        }
+
+        // С полным рюкзаком — ближайший офис, иначе ближайший из нескольких случайных трофеев
+        std::optional<model::Position> PickTarget(const GameSession &session, const Dog &dog)
+        {
+            const model::Position from = dog.GetPosition();
+            std::optional<model::Position> best;
+            double best_distance = 0.0;
+            auto consider = [&](model::Position pos)
+            {
+                const double distance = std::abs(pos.x - from.x) + std::abs(pos.y - from.y);
+                if (!best || distance < best_distance)
+                {
+                    best = pos;
+                    best_distance = distance;
+                }
+            };
+            if (!dog.CanPickUp())
+            {
+                for (const auto &office : session.GetMap()->GetOffices())
+                {
+                    consider({static_cast<double>(office.GetPosition().x), static_cast<double>(office.GetPosition().y)});
+                }
+                return best;
+            }
+            const auto &lost_objects = session.GetLostObjects();
+            if (lost_objects.empty())
+            {
+                return std::nullopt;
+            }
+            for (size_t i = 0; i < COLLECT_SAMPLES; ++i)
+            {
+                consider((lost_objects.begin() + static_cast<std::ptrdiff_t>(random_() % lost_objects.size()))->pos);
+            }
+            return best;
+        }
+
+        // Вдоль оси, по которой до цели дальше; собака идёт только по дорогам,
+        // поэтому упёршийся бот на следующем решении выбирает случайное направление
+        static Direction DirectionTo(model::Position from, model::Position to)
+        {
+            const double dx = to.x - from.x;
+            const double dy = to.y - from.y;
+            if (std::abs(dx) >= std::abs(dy) && std::abs(dx) > AXIS_EPSILON)
+            {
+                return dx > 0 ? Direction::EAST : Direction::WEST;
+            }
+            return dy > 0 ? Direction::SOUTH : Direction::NORTH;
+        }
+    };
+
+} // namespace bots
@@ -26,6 +26,13 @@ CollectionResult TryCollectPoint(geom::Point2D a, geom::Point2D b, geom::Point2D
 std::vector<GatheringEvent> FindGatherEvents(
     const ItemGathererProvider& provider) {
     std::vector<GatheringEvent> detected_events;
+    FindGatherEvents(provider, detected_events);
+    return detected_events;
+}
+
+void FindGatherEvents(const ItemGathererProvider& provider,
+                      std::vector<GatheringEvent>& detected_events) {
+    detected_events.clear();
 
     static auto eq_pt = [](geom::Point2D p1, geom::Point2D p2) {
         return p1.x == p2.x && p1.y == p2.y;
@@ -51,12 +58,12 @@ std::vector<GatheringEvent> FindGatherEvents(
         }
     }
 
+    // Одновременные события упорядочены по номеру предмета: порядок не зависит
+    // от того, как std::sort переставит равные элементы
     std::sort(detected_events.begin(), detected_events.end(),
               [](const GatheringEvent& e_l, const GatheringEvent& e_r) {
-                  return e_l.time < e_r.time;
+                  return e_l.time < e_r.time || (e_l.time == e_r.time && e_l.item_id < e_r.item_id);
               });
-
-    return detected_events;
 }
 
 }  // namespace collision_detector
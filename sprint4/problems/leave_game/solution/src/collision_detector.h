@@ -82,5 +82,7 @@ namespace collision_detector
     // Эту функцию вам нужно будет реализовать в соответствующем задании.
     // При проверке ваших тестов она не нужна - функция будет линковаться снаружи.
     std::vector<GatheringEvent> FindGatherEvents(const ItemGathererProvider &provider);
+    // То же, но события записываются в out: буфер очищается, а его память переиспользуется
+    void FindGatherEvents(const ItemGathererProvider &provider, std::vector<GatheringEvent> &out);
 
 } // namespace collision_detector
@@ -7,6 +7,9 @@
 #include <mutex>
 #include <condition_variable>
 #include <cassert>
+#include <chrono>
+
+#include "metrics.h"
 
 class ConnectionPool {
     using PoolType = ConnectionPool;
@@ -46,10 +49,12 @@ public:
     }
 
     ConnectionWrapper GetConnection() {
+        const auto start = std::chrono::steady_clock::now();
         std::unique_lock lock{mutex_};
         cond_var_.wait(lock, [this] {
             return used_connections_ < pool_.size();
         });
+        metrics::Observe(metrics::Timer::DB_POOL_WAIT, std::chrono::steady_clock::now() - start);
 
         return {std::move(pool_[used_connections_++]), *this};
     }
@@ -0,0 +1,163 @@
+#pragma once
+#include "http_server.h"
+#include "shared_string_body.h"
+
+#include <boost/asio/associated_executor.hpp>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/use_awaitable.hpp>
+
+#include <variant>
+
+namespace http_server {
+
+/*
+ *  Сессия на сопрограммах — альтернатива Session с тем же контрактом обработчика:
+ *  handler(request, send, client_ip), где send можно вызвать позже из другого потока.
+ *  Поток, буфер, запрос и ответ живут в кадре сопрограммы и переиспользуются
+ *  между запросами keep-alive соединения: ответ не переносится в кучу, а операции
+ *  не связывают обработчики с shared_from_this.
+ */
+namespace coro {
+
+// Типы ответов, которые отдаёт обработчик
+using Response = std::variant<std::monostate, http::response<http::string_body>, http::response<SharedStringBody>>;
+
+// Кладёт ответ в кадр сопрограммы и возобновляет её в исполнителе соединения
+template <typename Completion>
+class Sender {
+public:
+    Sender(Response& slot, Completion&& completion)
+        : slot_(&slot)
+        , completion_(std::move(completion)) {
+    }
+
+    // Исполнитель сопрограммы, то есть соединения: по нему обработчик выбирает io_context для файлов
+    using executor_type = net::associated_executor_t<Completion>;
+    executor_type get_executor() const noexcept {
+        return net::get_associated_executor(completion_);
+    }
+
+    template <typename Body, typename Fields>
+    void operator()(http::response<Body, Fields>&& response) {
+        slot_->template emplace<http::response<Body, Fields>>(std::move(response));
+        // Ответ может прийти из strand игры или пула блокирующих задач: сопрограмма продолжится в своём исполнителе
+        net::post(std::move(completion_));
+    }
+
+private:
+    Response* slot_;
+    Completion completion_;
+};
+
+// Ждёт, пока обработчик вызовет send, и возвращает управление с ответом в slot
+template <typename RequestHandler>
+auto AsyncHandle(RequestHandler& handler, http::request<http::string_body>&& request, Response& slot,
+                 const std::string& client_ip) {
+    return net::async_initiate<decltype(net::use_awaitable), void()>(
+        [&handler, &request, &slot, &client_ip](auto completion) {
+            handler(std::move(request), Sender<decltype(completion)>{slot, std::move(completion)}, client_ip);
+        },
+        net::use_awaitable);
+}
+
+template <typename RequestHandler>
+net::awaitable<void> RunSession(tcp::socket socket, RequestHandler handler, std::string client_ip) {
+    metrics::Add(metrics::Counter::ACTIVE_CONNECTIONS, 1);
+    struct ConnectionGuard {
+        ~ConnectionGuard() {
+            metrics::Add(metrics::Counter::ACTIVE_CONNECTIONS, -1);
+        }
+    } guard;
+
+    beast::tcp_stream stream(std::move(socket));
+    beast::flat_buffer buffer;
+    http::request<http::string_body> request;
+    Response response;
+    beast::error_code ec;
+
+    for (;;) {
+        request = {};
+        stream.expires_after(30s);
+        co_await http::async_read(stream, buffer, request, net::redirect_error(net::use_awaitable, ec));
+        if (ec == http::error::end_of_stream) {
+            break;
+        }
+        if (ec) {
+            ReportError(ec, "read"sv);
+            co_return;
+        }
+
+        co_await AsyncHandle(handler, std::move(request), response, client_ip);
+
+        bool close = false;
+        if (auto* res = std::get_if<http::response<http::string_body>>(&response)) {
+            close = res->need_eof();
+            co_await http::async_write(stream, *res, net::redirect_error(net::use_awaitable, ec));
+        } else if (auto* res = std::get_if<http::response<SharedStringBody>>(&response)) {
+            close = res->need_eof();
+            co_await http::async_write(stream, *res, net::redirect_error(net::use_awaitable, ec));
+        }
+        response.emplace<std::monostate>();
+        if (ec) {
+            ReportError(ec, "write"sv);
+            co_return;
+        }
+        if (close) {
+            break;
+        }
+    }
+    stream.socket().shutdown(tcp::socket::shutdown_send, ec);
+}
+
+// Пауза перед новой попыткой после ошибки accept
+inline constexpr auto ACCEPT_RETRY_DELAY = 100ms;
+
+template <typename RequestHandler>
+net::awaitable<void> Listen(net::io_context& ioc, tcp::acceptor acceptor, RequestHandler handler) {
+    net::steady_timer retry_timer(acceptor.get_executor());
+    for (;;) {
+        // Каждое соединение работает в своём strand, как и в Listener
+        tcp::socket socket(net::make_strand(ioc));
+        sys::error_code ec;
+        co_await acceptor.async_accept(socket, net::redirect_error(net::use_awaitable, ec));
+        if (ec == net::error::operation_aborted) {
+            // Слушающий сокет закрыт: сервер останавливается
+            co_return;
+        }
+        if (ec) {
+            ReportError(ec, "accept"sv);
+            // Ошибки вроде EMFILE сами не проходят: без паузы цикл крутился бы впустую
+            // и заваливал лог, пока не освободятся дескрипторы
+            retry_timer.expires_after(ACCEPT_RETRY_DELAY);
+            co_await retry_timer.async_wait(net::redirect_error(net::use_awaitable, ec));
+            if (ec == net::error::operation_aborted) {
+                co_return;
+            }
+            continue;
+        }
+        std::string client_ip = socket.remote_endpoint(ec).address().to_string();
+        const auto executor = socket.get_executor();
+        net::co_spawn(executor, RunSession(std::move(socket), handler, std::move(client_ip)), net::detached);
+    }
+}
+
+}  // namespace coro
+
+// То же, что ServeHttp, но соединения обслуживаются сопрограммами
+template <typename RequestHandler>
+void ServeHttpCoro(net::io_context& ioc, const tcp::endpoint& endpoint, RequestHandler&& handler, bool share_port = false) {
+    // Ошибка привязки к адресу, как и в Listener, выбрасывается сразу, а не теряется в сопрограмме
+    tcp::acceptor acceptor(net::make_strand(ioc));
+    OpenAcceptor(acceptor, endpoint, share_port);
+
+    const auto executor = acceptor.get_executor();
+    net::co_spawn(executor,
+                  coro::Listen(ioc, std::move(acceptor), std::decay_t<RequestHandler>(std::forward<RequestHandler>(handler))),
+                  net::detached);
+}
+
+}  // namespace http_server
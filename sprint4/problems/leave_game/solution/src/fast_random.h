@@ -0,0 +1,49 @@
+#pragma once
+#include <cstdint>
+#include <limits>
+#include <random>
+
+namespace util {
+
+/*
+ *  Быстрый генератор псевдослучайных чисел SplitMix64.
+ *  Состояние — одно 64-битное число, поэтому генератор дёшево хранить
+ *  в каждой игровой сессии и не нужен ни rand(), ни общий для потоков движок.
+ *  Удовлетворяет требованиям UniformRandomBitGenerator.
+ */
+class FastRandom {
+public:
+    using result_type = uint64_t;
+
+    FastRandom()
+        : state_{(static_cast<uint64_t>(std::random_device{}()) << 32) ^ std::random_device{}()} {
+    }
+
+    explicit FastRandom(uint64_t seed) noexcept
+        : state_{seed} {
+    }
+
+    static constexpr result_type min() noexcept {
+        return 0;
+    }
+    static constexpr result_type max() noexcept {
+        return std::numeric_limits<result_type>::max();
+    }
+
+    result_type operator()() noexcept {
+        uint64_t z = (state_ += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    // Равномерное число из [0, 1)
+    double NextDouble() noexcept {
+        return static_cast<double>((*this)() >> 11) * 0x1.0p-53;
+    }
+
+private:
+    uint64_t state_;
+};
+
+}  // namespace util
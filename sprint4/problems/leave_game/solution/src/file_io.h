@@ -0,0 +1,109 @@
+#pragma once
+#include <boost/asio/post.hpp>
+#include <boost/system/error_code.hpp>
+#ifdef BOOST_ASIO_HAS_FILE
+#include <boost/asio/random_access_file.hpp>
+#include <boost/asio/read_at.hpp>
+#include <boost/asio/write_at.hpp>
+#endif
+
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+
+/*
+ *  Чтение и запись файла целиком без блокировки потока.
+ *  В сборке с io_uring (GAME_SERVER_IO_URING) используется random_access_file,
+ *  и операции выполняет ядро. Без него файл читается и пишется обычными потоками
+ *  в вызывающем потоке, а обработчик вызывается через post — контракт тот же.
+ */
+namespace file_io {
+
+namespace net = boost::asio;
+namespace sys = boost::system;
+namespace fs = std::filesystem;
+
+// Выполняются ли файловые операции асинхронно в этой сборке
+constexpr bool IsAsync() {
+#ifdef BOOST_ASIO_HAS_FILE
+    return true;
+#else
+    return false;
+#endif
+}
+
+// Вызывает handler(ec, content) в исполнителе executor
+template <typename Executor, typename Handler>
+void AsyncReadFile(const Executor& executor, const fs::path& path, Handler&& handler) {
+#ifdef BOOST_ASIO_HAS_FILE
+    auto file = std::make_unique<net::random_access_file>(executor);
+    sys::error_code ec;
+    file->open(path.string(), net::file_base::read_only, ec);
+    const uint64_t size = ec ? 0 : file->size(ec);
+    if (ec) {
+        net::post(executor, [handler = std::forward<Handler>(handler), ec]() mutable {
+            handler(ec, std::string{});
+        });
+        return;
+    }
+    // Буфер в куче: его адрес не меняется, когда обработчик перемещается в операцию
+    auto content = std::make_unique<std::string>(size, '\0');
+    auto buffer = net::buffer(*content);
+    auto& file_ref = *file;
+    net::async_read_at(file_ref, 0, buffer,
+                       [file = std::move(file), content = std::move(content),
+                        handler = std::forward<Handler>(handler)](sys::error_code ec, size_t read) mutable {
+                           // Файл мог укоротиться между size и чтением
+                           if (ec == net::error::eof) {
+                               ec = {};
+                           }
+                           content->resize(read);
+                           handler(ec, std::move(*content));
+                       });
+#else
+    std::ifstream file(path, std::ios::binary);
+    std::ostringstream content;
+    content << file.rdbuf();
+    const sys::error_code ec = file ? sys::error_code{} : sys::errc::make_error_code(sys::errc::io_error);
+    net::post(executor, [handler = std::forward<Handler>(handler), ec, content = content.str()]() mutable {
+        handler(ec, std::move(content));
+    });
+#endif
+}
+
+// Заменяет содержимое файла на content и вызывает handler(ec) в исполнителе executor
+template <typename Executor, typename Handler>
+void AsyncWriteFile(const Executor& executor, const fs::path& path, std::string content, Handler&& handler) {
+#ifdef BOOST_ASIO_HAS_FILE
+    auto file = std::make_unique<net::random_access_file>(executor);
+    sys::error_code ec;
+    file->open(path.string(), net::file_base::write_only | net::file_base::create | net::file_base::truncate, ec);
+    if (ec) {
+        net::post(executor, [handler = std::forward<Handler>(handler), ec]() mutable {
+            handler(ec);
+        });
+        return;
+    }
+    auto data = std::make_unique<std::string>(std::move(content));
+    auto buffer = net::buffer(*data);
+    auto& file_ref = *file;
+    net::async_write_at(file_ref, 0, buffer,
+                        [file = std::move(file), data = std::move(data),
+                         handler = std::forward<Handler>(handler)](sys::error_code ec, size_t) mutable {
+                            handler(ec);
+                        });
+#else
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(content.data(), static_cast<std::streamsize>(content.size()));
+    file.close();
+    const sys::error_code ec = file ? sys::error_code{} : sys::errc::make_error_code(sys::errc::io_error);
+    net::post(executor, [handler = std::forward<Handler>(handler), ec]() mutable {
+        handler(ec);
+    });
+#endif
+}
+
+}  // namespace file_io
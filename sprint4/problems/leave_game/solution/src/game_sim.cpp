@@ -0,0 +1,439 @@
+// Симулятор без сети: загружает конфигурацию игры и с максимальной скоростью
+// проигрывает журнал действий и тиков. Печатает скорость и хеш итогового состояния,
+// по которому видно, что оптимизация движка не изменила результат игры.
+//
+// Формат журнала — по команде в строке, # начинает комментарий:
+//   join <map id> <name>       — новый игрок, получает следующий по порядку номер
+//   move <player> <U|D|L|R>    — команда собаке игрока
+//   tick <ms>                  — шаг симуляции
+#include "sdk.h"
+
+#include <boost/program_options.hpp>
+
+#include <bit>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "fast_random.h"
+#include "json_loader.h"
+#include "objects.h"
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+    using namespace std::literals;
+
+    struct Config
+    {
+        std::string config_file;
+        std::string log_file = "-";
+        uint64_t seed = 1;
+        bool randomize_spawn = false;
+        // Параметры синтетического журнала
+        unsigned players = 1000;
+        unsigned ticks = 1000;
+        int tick_ms = 50;
+        double actions_per_tick = 100.0;
+    };
+
+    // FNV-1a: порядок и значения всех полей состояния влияют на результат
+    class StateHasher
+    {
+    public:
+        template <typename T>
+        void Add(const T &value)
+        {
+            if constexpr (std::is_same_v<T, double>)
+            {
+                AddBytes(std::bit_cast<uint64_t>(value));
+            }
+            else
+            {
+                AddBytes(static_cast<uint64_t>(value));
+            }
+        }
+        void Add(std::string_view text)
+        {
+            for (const char c : text)
+            {
+                Mix(static_cast<uint8_t>(c));
+            }
+            Add(text.size());
+        }
+        uint64_t GetHash() const { return hash_; }
+
+    private:
+        void AddBytes(uint64_t value)
+        {
+            for (int i = 0; i < 8; ++i)
+            {
+                Mix(static_cast<uint8_t>(value >> (i * 8)));
+            }
+        }
+        void Mix(uint8_t byte)
+        {
+            hash_ = (hash_ ^ byte) * 0x100000001B3ull;
+        }
+
+        uint64_t hash_ = 0xCBF29CE484222325ull;
+    };
+
+    struct SimPlayer
+    {
+        std::shared_ptr<GameSession> session;
+        std::shared_ptr<Dog> dog;
+    };
+
+    // Повторяет фазы RunTick сервера, кроме сохранения и публикации снимков
+    class Simulator
+    {
+    public:
+        Simulator(model::Game &game, const Config &config)
+            : game_{game}, randomize_spawn_{config.randomize_spawn}
+        {
+            for (size_t i = 0; i < game_.GetMapCount(); ++i)
+            {
+                model::Map *map = game_.FindMap(game_.GetMaps()[i].GetId());
+                auto session = std::make_shared<GameSession>(map);
+                session->SeedRandom(config.seed + i);
+                sessions_.push_back(std::move(session));
+            }
+        }
+
+        bool Join(std::string_view map_id, std::string_view name)
+        {
+            const model::Map *map = game_.FindMap(model::Map::Id{std::string(map_id)});
+            if (!map)
+            {
+                return false;
+            }
+            const auto &session = sessions_[map->GetIndex()];
+            players_.push_back({session, session->AddDog(name, randomize_spawn_)});
+            return true;
+        }
+
+        // Команды ушедшим на покой игрокам игнорируются, как и на сервере
+        bool Move(size_t player_index, Direction dir)
+        {
+            if (player_index >= players_.size())
+            {
+                return false;
+            }
+            SimPlayer &player = players_[player_index];
+            if (player.dog && player.dog->IsRetired())
+            {
+                player.dog.reset();
+            }
+            if (player.dog)
+            {
+                player.session->SteerDog(player.dog, dir, player.session->GetMap()->GetSpeedForThisMap());
+            }
+            return true;
+        }
+
+        void Tick(int ms)
+        {
+            for (const auto &session : sessions_)
+            {
+                session->MoveDogs(ms);
+            }
+            for (const auto &session : sessions_)
+            {
+                session->GatherLoot();
+            }
+            for (const auto &session : sessions_)
+            {
+                for (const auto &dog : session->GetRetiredDogs())
+                {
+                    records_.Add(dog->GetName());
+                    records_.Add(dog->GetScore());
+                    records_.Add(dog->GetLifeTime());
+                    session->RemoveDog(dog->GetId());
+                    ++retired_count_;
+                }
+                session->ClearRetiredDogs();
+            }
+            for (const auto &session : sessions_)
+            {
+                session->SpawnLoot(std::chrono::milliseconds{ms});
+            }
+            ++tick_count_;
+        }
+
+        uint64_t GetStateHash() const
+        {
+            StateHasher hasher;
+            hasher.Add(records_.GetHash());
+            for (const auto &session : sessions_)
+            {
+                hasher.Add(session->GetDogs().size());
+                for (const auto &dog : session->GetDogs())
+                {
+                    hasher.Add(dog->GetId());
+                    hasher.Add(dog->GetPosition().x);
+                    hasher.Add(dog->GetPosition().y);
+                    hasher.Add(dog->GetScore());
+                    for (const auto &[id, type] : dog->GetBag())
+                    {
+                        hasher.Add(id);
+                        hasher.Add(type);
+                    }
+                }
+                hasher.Add(session->GetLostObjects().size());
+                for (const auto &obj : session->GetLostObjects())
+                {
+                    hasher.Add(obj.id);
+                    hasher.Add(obj.type);
+                    hasher.Add(obj.pos.x);
+                    hasher.Add(obj.pos.y);
+                }
+            }
+            return hasher.GetHash();
+        }
+
+        uint64_t GetTickCount() const { return tick_count_; }
+        uint64_t GetRetiredCount() const { return retired_count_; }
+        size_t GetPlayerCount() const { return players_.size(); }
+        size_t GetDogCount() const
+        {
+            size_t count = 0;
+            for (const auto &session : sessions_)
+            {
+                count += session->GetDogs().size();
+            }
+            return count;
+        }
+
+    private:
+        model::Game &game_;
+        bool randomize_spawn_;
+        std::vector<std::shared_ptr<GameSession>> sessions_;
+        // Игроки объявлены после сессий: собаки живут в памяти своих сессий
+        std::vector<SimPlayer> players_;
+        StateHasher records_;
+        uint64_t tick_count_ = 0;
+        uint64_t retired_count_ = 0;
+    };
+
+    struct Command
+    {
+        enum class Kind
+        {
+            JOIN,
+            MOVE,
+            TICK
+        };
+        Kind kind;
+        size_t player = 0;
+        Direction dir = Direction::NORTH;
+        int ms = 0;
+        std::string map_id;
+        std::string name;
+    };
+
+    std::optional<Direction> ParseDirection(std::string_view dir)
+    {
+        if (dir == "U"sv)
+            return Direction::NORTH;
+        if (dir == "D"sv)
+            return Direction::SOUTH;
+        if (dir == "L"sv)
+            return Direction::WEST;
+        if (dir == "R"sv)
+            return Direction::EAST;
+        return std::nullopt;
+    }
+
+    // Журнал разбирается заранее, чтобы в замер попадала только симуляция
+    std::optional<std::vector<Command>> ParseLog(std::istream &input)
+    {
+        std::vector<Command> commands;
+        std::string line;
+        size_t line_number = 0;
+        while (std::getline(input, line))
+        {
+            ++line_number;
+            const auto comment = line.find('#');
+            if (comment != std::string::npos)
+            {
+                line.resize(comment);
+            }
+            std::istringstream fields{line};
+            std::string keyword;
+            if (!(fields >> keyword))
+            {
+                continue;
+            }
+            Command command{};
+            bool ok = false;
+            if (keyword == "tick")
+            {
+                command.kind = Command::Kind::TICK;
+                ok = (fields >> command.ms) && command.ms >= 0;
+            }
+            else if (keyword == "move")
+            {
+                command.kind = Command::Kind::MOVE;
+                std::string dir;
+                ok = static_cast<bool>(fields >> command.player >> dir);
+                const auto direction = ParseDirection(dir);
+                ok = ok && direction;
+                command.dir = direction.value_or(Direction::NORTH);
+            }
+            else if (keyword == "join")
+            {
+                command.kind = Command::Kind::JOIN;
+                ok = static_cast<bool>(fields >> command.map_id >> command.name);
+            }
+            if (!ok)
+            {
+                std::cerr << "Invalid log line " << line_number << ": " << line << std::endl;
+                return std::nullopt;
+            }
+            commands.push_back(std::move(command));
+        }
+        return commands;
+    }
+
+    bool Replay(const std::vector<Command> &commands, Simulator &sim)
+    {
+        for (size_t i = 0; i < commands.size(); ++i)
+        {
+            const Command &command = commands[i];
+            bool ok = true;
+            switch (command.kind)
+            {
+            case Command::Kind::TICK:
+                sim.Tick(command.ms);
+                break;
+            case Command::Kind::MOVE:
+                ok = sim.Move(command.player, command.dir);
+                break;
+            case Command::Kind::JOIN:
+                ok = sim.Join(command.map_id, command.name);
+                break;
+            }
+            if (!ok)
+            {
+                std::cerr << "Command " << i + 1 << " refers to an unknown player or map" << std::endl;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Воспроизводимый журнал для замеров: игроки равномерно по картам, случайные команды
+    void Synthesize(const model::Game &game, const Config &config, std::ostream &out)
+    {
+        util::FastRandom random{config.seed};
+        const auto &maps = game.GetMaps();
+        for (unsigned i = 0; i < config.players; ++i)
+        {
+            out << "join " << *maps[i % maps.size()].GetId() << " bot" << i << '\n';
+        }
+        constexpr std::string_view DIRECTIONS[] = {"U"sv, "D"sv, "L"sv, "R"sv};
+        for (unsigned tick = 0; tick < config.ticks; ++tick)
+        {
+            double actions = config.actions_per_tick;
+            for (; actions >= 1.0 || random.NextDouble() < actions; actions -= 1.0)
+            {
+                out << "move " << random() % config.players << ' ' << DIRECTIONS[random() % 4] << '\n';
+            }
+            out << "tick " << config.tick_ms << '\n';
+        }
+    }
+} // namespace
+
+int main(int argc, const char *argv[])
+{
+    namespace po = boost::program_options;
+
+    Config config;
+    po::options_description desc("Allowed options");
+    desc.add_options()("help,h", "produce help message")("config-file,c", po::value(&config.config_file), "game config file path")("log,l", po::value(&config.log_file), "action log to replay, - for stdin")("seed,s", po::value(&config.seed), "random seed for loot and spawn points")("randomize-spawn-points", "spawn dogs at random positions")("synthesize", "write a random action log to stdout instead of replaying")("players,n", po::value(&config.players), "players in synthesized log")("ticks", po::value(&config.ticks), "ticks in synthesized log")("tick-ms", po::value(&config.tick_ms), "tick length in synthesized log")("actions-per-tick", po::value(&config.actions_per_tick), "average actions per tick in synthesized log");
+
+    po::variables_map vm;
+    try
+    {
+        po::store(po::parse_command_line(argc, argv, desc), vm);
+        po::notify(vm);
+    }
+    catch (const std::exception &ex)
+    {
+        std::cerr << "Error parsing command line: " << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (vm.count("help") || config.config_file.empty())
+    {
+        std::cout << desc << std::endl;
+        return EXIT_SUCCESS;
+    }
+    config.randomize_spawn = vm.count("randomize-spawn-points") > 0;
+
+    try
+    {
+        model::Game game = json_loader::LoadGame(config.config_file);
+        if (game.GetMapCount() == 0)
+        {
+            std::cerr << "No maps in " << config.config_file << std::endl;
+            return EXIT_FAILURE;
+        }
+        if (vm.count("synthesize"))
+        {
+            if (config.players == 0)
+            {
+                std::cerr << "players must be positive" << std::endl;
+                return EXIT_FAILURE;
+            }
+            Synthesize(game, config, std::cout);
+            return EXIT_SUCCESS;
+        }
+
+        std::ifstream log_file;
+        if (config.log_file != "-")
+        {
+            log_file.open(config.log_file);
+            if (!log_file)
+            {
+                std::cerr << "Failed to open " << config.log_file << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+        std::istream &input = config.log_file == "-" ? std::cin : log_file;
+
+        const auto commands = ParseLog(input);
+        if (!commands)
+        {
+            return EXIT_FAILURE;
+        }
+        Simulator sim{game, config};
+        const auto start = Clock::now();
+        if (!Replay(*commands, sim))
+        {
+            return EXIT_FAILURE;
+        }
+        const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        std::printf("players   %zu\n", sim.GetPlayerCount());
+        std::printf("dogs      %zu\n", sim.GetDogCount());
+        std::printf("retired   %llu\n", static_cast<unsigned long long>(sim.GetRetiredCount()));
+        std::printf("ticks     %llu\n", static_cast<unsigned long long>(sim.GetTickCount()));
+        std::printf("seconds   %.3f\n", seconds);
+        std::printf("ticks/s   %.1f\n", seconds > 0.0 ? sim.GetTickCount() / seconds : 0.0);
+        std::printf("hash      %016llx\n", static_cast<unsigned long long>(sim.GetStateHash()));
+        return EXIT_SUCCESS;
+    }
+    catch (const std::exception &ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -3,6 +3,8 @@
 // boost.beast будет использовать std::string_view вместо boost::string_view
 #define BOOST_BEAST_USE_STD_STRING_VIEW
 
+#include <boost/asio/bind_executor.hpp>
+#include <boost/asio/dispatch.hpp>
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/asio/strand.hpp>
 #include <boost/beast/core.hpp>
@@ -13,6 +15,8 @@
 #include <boost/log/utility/setup/console.hpp>
 #include <iostream>
 
+#include "metrics.h"
+
 
 namespace http_server {
 
@@ -28,6 +32,28 @@ namespace json = boost::json;
 
 BOOST_LOG_ATTRIBUTE_KEYWORD(additional_data, "AdditionalData", json::value)
 
+// SO_REUSEPORT: несколько сокетов слушают один порт, а ядро распределяет между ними соединения
+using reuse_port = net::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+
+// Открывает сокет, слушающий endpoint. Ошибка привязки выбрасывается как исключение
+inline void OpenAcceptor(tcp::acceptor& acceptor, const tcp::endpoint& endpoint, bool share_port) {
+    // Открываем acceptor, используя протокол (IPv4 или IPv6), указанный в endpoint
+    acceptor.open(endpoint.protocol());
+    // После закрытия TCP-соединения сокет некоторое время может считаться занятым,
+    // чтобы компьютеры могли обменяться завершающими пакетами данных.
+    // Однако это может помешать повторно открыть сокет в полузакрытом состоянии.
+    // Флаг reuse_address разрешает открыть сокет, когда он "наполовину закрыт"
+    acceptor.set_option(net::socket_base::reuse_address(true));
+    if (share_port) {
+        acceptor.set_option(reuse_port(true));
+    }
+    // Привязываем acceptor к адресу и порту endpoint
+    acceptor.bind(endpoint);
+    // Переводим acceptor в состояние, в котором он способен принимать новые соединения
+    // Благодаря этому новые подключения будут помещаться в очередь ожидающих соединений
+    acceptor.listen(net::socket_base::max_listen_connections);
+}
+
 inline void ReportError(beast::error_code ec, std::string_view where) {
     json::object err_data;
     err_data["code"] = ec.value();
@@ -45,19 +71,29 @@ protected:
     using HttpRequest = http::request<http::string_body>;
     explicit SessionBase(tcp::socket&& socket)
         : stream_(std::move(socket)) {
+        metrics::Add(metrics::Counter::ACTIVE_CONNECTIONS, 1);
     }
     template <typename Body, typename Fields>
     void Write(http::response<Body, Fields>&& response) {
         // Запись выполняется асинхронно, поэтому response перемещаем в область кучи
         auto safe_response = std::make_shared<http::response<Body, Fields>>(std::move(response));
 
-        auto self = GetSharedThis();
-        http::async_write(stream_, *safe_response,
-                          [safe_response, self](beast::error_code ec, std::size_t bytes_written) {
-                              self->OnWrite(safe_response->need_eof(), ec, bytes_written);
-                          });
+        // Ответ может прийти из strand игры или пула блокирующих задач, а в режиме
+        // --io-contexts они работают в чужом io_context. Сокет трогаем только
+        // в его исполнителе: в своём потоке dispatch выполнит запись сразу
+        net::dispatch(stream_.get_executor(), [safe_response, self = GetSharedThis(), this] {
+            http::async_write(stream_, *safe_response,
+                              [safe_response, self](beast::error_code ec, std::size_t bytes_written) {
+                                  self->OnWrite(safe_response->need_eof(), ec, bytes_written);
+                              });
+        });
+    }
+    beast::tcp_stream::executor_type GetExecutor() {
+        return stream_.get_executor();
+    }
+    ~SessionBase() {
+        metrics::Add(metrics::Counter::ACTIVE_CONNECTIONS, -1);
     }
-    ~SessionBase() = default;
 private:
     // tcp_stream содержит внутри себя сокет и добавляет поддержку таймаутов
     beast::tcp_stream stream_;
@@ -128,10 +164,12 @@ private:
     } 
     void HandleRequest(HttpRequest&& request) override {
         auto self = this->shared_from_this();
+        // Исполнитель сессии связан с send: по нему обработчик выбирает io_context для файлов
         request_handler_(std::move(request),
-                         [self](auto&& response) {
-                             self->Write(std::move(response));
-                         },
+                         net::bind_executor(GetExecutor(),
+                                            [self](auto&& response) {
+                                                self->Write(std::move(response));
+                                            }),
                          client_ip_);
     }
 };
@@ -139,25 +177,14 @@ private:
 template <typename RequestHandler>
 class Listener : public std::enable_shared_from_this<Listener<RequestHandler>> {
 public:
+    // share_port разрешает другим Listener слушать тот же порт (SO_REUSEPORT)
     template <typename Handler>
-    Listener(net::io_context& ioc, const tcp::endpoint& endpoint, Handler&& request_handler)
+    Listener(net::io_context& ioc, const tcp::endpoint& endpoint, Handler&& request_handler, bool share_port = false)
         : ioc_(ioc)
         // Обработчики асинхронных операций acceptor_ будут вызываться в своём strand
         , acceptor_(net::make_strand(ioc))
         , request_handler_(std::forward<Handler>(request_handler)) {
-        // Открываем acceptor, используя протокол (IPv4 или IPv6), указанный в endpoint
-        acceptor_.open(endpoint.protocol());
-
-        // После закрытия TCP-соединения сокет некоторое время может считаться занятым,
-        // чтобы компьютеры могли обменяться завершающими пакетами данных.
-        // Однако это может помешать повторно открыть сокет в полузакрытом состоянии.
-        // Флаг reuse_address разрешает открыть сокет, когда он "наполовину закрыт"
-        acceptor_.set_option(net::socket_base::reuse_address(true));
-        // Привязываем acceptor к адресу и порту endpoint
-        acceptor_.bind(endpoint);
-        // Переводим acceptor в состояние, в котором он способен принимать новые соединения
-        // Благодаря этому новые подключения будут помещаться в очередь ожидающих соединений
-        acceptor_.listen(net::socket_base::max_listen_connections);
+        OpenAcceptor(acceptor_, endpoint, share_port);
     }
     void Run() {
         DoAccept();
@@ -201,12 +228,12 @@ private:
     RequestHandler request_handler_;
 };
 template <typename RequestHandler>
-void ServeHttp(net::io_context& ioc, const tcp::endpoint& endpoint, RequestHandler&& handler) {
+void ServeHttp(net::io_context& ioc, const tcp::endpoint& endpoint, RequestHandler&& handler, bool share_port = false) {
     // При помощи decay_t исключим ссылки из типа RequestHandler,
     // чтобы Listener хранил RequestHandler по значению
     using MyListener = Listener<std::decay_t<RequestHandler>>;
 
-    std::make_shared<MyListener>(ioc, endpoint, std::forward<RequestHandler>(handler))->Run();
+    std::make_shared<MyListener>(ioc, endpoint, std::forward<RequestHandler>(handler), share_port)->Run();
 }
 
 }  // namespace http_server
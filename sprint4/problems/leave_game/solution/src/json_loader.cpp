@@ -92,7 +92,6 @@ namespace json_loader
             std::chrono::milliseconds(static_cast<int>(period_sec * 1000.0)),
             probability};
 
-        extra_data::GetInstance().SetLootGenerator(map.GetId(), generator);
         map.SetLootGenerator(std::move(generator));
     }
 
@@ -109,8 +108,32 @@ namespace json_loader
             throw std::runtime_error("lootTypes must not be empty");
         }
 
+        model::Map::LootTypes loot_types;
+        loot_types.reserve(loot_array.size());
+        uint64_t total_weight = 0;
+        for (const auto &loot_json : loot_array)
+        {
+            const auto &loot_obj = loot_json.as_object();
+            model::LootType loot_type;
+            if (const auto *value = loot_obj.if_contains("value"))
+            {
+                loot_type.value = static_cast<int>(value->as_int64());
+            }
+            if (const auto *weight = loot_obj.if_contains("weight"))
+            {
+                loot_type.weight = static_cast<unsigned>(weight->as_int64());
+            }
+            total_weight += loot_type.weight;
+            loot_types.push_back(loot_type);
+        }
+        if (total_weight == 0)
+        {
+            throw std::runtime_error("lootTypes weights must not all be zero");
+        }
+        map.SetLootTypes(std::move(loot_types));
+
+        // Исходный JSON нужен только для ответа /api/v1/maps/{id}
         extra_data::GetInstance().SetLootTypes(map.GetId(), loot_array);
-        map.SetLootTypeCount(static_cast<int>(loot_array.size()));
     }
     void SetBagCapacity(model::Map &map, const boost::json::object &root, const boost::json::object &map_obj)
     {
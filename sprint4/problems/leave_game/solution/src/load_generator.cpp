@@ -0,0 +1,448 @@
+// Генератор нагрузки: подключает N игроков и гоняет смесь запросов
+// по keep-alive соединениям с заданной интенсивностью.
+#include "sdk.h"
+// boost.beast будет использовать std::string_view вместо boost::string_view
+#define BOOST_BEAST_USE_STD_STRING_VIEW
+
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/strand.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/json.hpp>
+#include <boost/program_options.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "metrics.h"
+
+namespace
+{
+    namespace net = boost::asio;
+    namespace beast = boost::beast;
+    namespace http = beast::http;
+    namespace json = boost::json;
+    using tcp = net::ip::tcp;
+    using Clock = std::chrono::steady_clock;
+    using namespace std::literals;
+
+    enum class Kind : size_t
+    {
+        JOIN,
+        ACTION,
+        STATE,
+        PLAYERS,
+        RECORDS,
+        MAPS,
+        COUNT
+    };
+
+    constexpr size_t KIND_COUNT = static_cast<size_t>(Kind::COUNT);
+    constexpr std::array<std::string_view, KIND_COUNT> KIND_NAMES = {"join"sv, "action"sv, "state"sv, "players"sv, "records"sv, "maps"sv};
+
+    // Задержки складываются в те же корзины, что и серверные метрики
+    struct Stats
+    {
+        std::array<uint64_t, metrics::Buckets::COUNT> buckets{};
+        uint64_t count = 0;
+        uint64_t errors = 0;
+        uint64_t sum_us = 0;
+        uint64_t max_us = 0;
+
+        void Add(Clock::duration latency, bool ok)
+        {
+            const auto us = static_cast<uint64_t>(std::max<int64_t>(
+                std::chrono::duration_cast<std::chrono::microseconds>(latency).count(), 0));
+            ++buckets[metrics::Buckets::Index(us)];
+            ++count;
+            sum_us += us;
+            max_us = std::max(max_us, us);
+            if (!ok)
+            {
+                ++errors;
+            }
+        }
+
+        void Merge(const Stats &other)
+        {
+            for (size_t i = 0; i < buckets.size(); ++i)
+            {
+                buckets[i] += other.buckets[i];
+            }
+            count += other.count;
+            errors += other.errors;
+            sum_us += other.sum_us;
+            max_us = std::max(max_us, other.max_us);
+        }
+
+        uint64_t Percentile(double q) const
+        {
+            const auto rank = static_cast<uint64_t>(q * static_cast<double>(count));
+            uint64_t seen = 0;
+            for (size_t i = 0; i < buckets.size(); ++i)
+            {
+                seen += buckets[i];
+                if (seen > rank)
+                {
+                    return std::min(metrics::Buckets::UpperBound(i), max_us);
+                }
+            }
+            return max_us;
+        }
+    };
+
+    using StatsTable = std::array<Stats, KIND_COUNT>;
+
+    struct Config
+    {
+        std::string host = "127.0.0.1";
+        std::string port = "8080";
+        unsigned players = 100;
+        std::vector<std::string> maps{"map1"};
+        unsigned connections = 16;
+        double rps = 1000.0;
+        std::chrono::seconds duration{10};
+        unsigned threads = 1;
+        // Веса запросов в смеси, индекс — Kind
+        std::array<double, KIND_COUNT> weights{0.0, 60.0, 30.0, 5.0, 5.0, 0.0};
+    };
+
+    // Одно keep-alive соединение с сервером
+    class Connection
+    {
+    public:
+        Connection(net::any_io_executor executor, const Config &config)
+            : stream_{executor}, config_{config}
+        {
+        }
+
+        net::awaitable<http::response<http::string_body>> Send(http::request<http::string_body> &req)
+        {
+            if (!connected_)
+            {
+                co_await Connect();
+            }
+            stream_.expires_after(30s);
+            co_await http::async_write(stream_, req, net::use_awaitable);
+            http::response<http::string_body> res;
+            co_await http::async_read(stream_, buffer_, res, net::use_awaitable);
+            if (res.need_eof())
+            {
+                Close();
+            }
+            co_return res;
+        }
+
+        void Close()
+        {
+            beast::error_code ec;
+            stream_.socket().shutdown(tcp::socket::shutdown_both, ec);
+            stream_.close();
+            buffer_.clear();
+            connected_ = false;
+        }
+
+    private:
+        net::awaitable<void> Connect()
+        {
+            tcp::resolver resolver{stream_.get_executor()};
+            const auto endpoints = co_await resolver.async_resolve(config_.host, config_.port, net::use_awaitable);
+            stream_.expires_after(30s);
+            co_await stream_.async_connect(endpoints, net::use_awaitable);
+            stream_.socket().set_option(tcp::no_delay(true));
+            connected_ = true;
+        }
+
+        beast::tcp_stream stream_;
+        beast::flat_buffer buffer_;
+        const Config &config_;
+        bool connected_ = false;
+    };
+
+    struct Player
+    {
+        std::string token;
+    };
+
+    http::request<http::string_body> MakeRequest(const Config &config, http::verb method, std::string_view target,
+                                                 std::string_view token = {}, std::string body = {})
+    {
+        http::request<http::string_body> req{method, target, 11};
+        req.set(http::field::host, config.host);
+        req.keep_alive(true);
+        if (!token.empty())
+        {
+            req.set(http::field::authorization, "Bearer "s + std::string(token));
+        }
+        if (method == http::verb::post)
+        {
+            req.set(http::field::content_type, "application/json");
+            req.body() = std::move(body);
+        }
+        req.prepare_payload();
+        return req;
+    }
+
+    net::awaitable<void> JoinPlayers(const Config &config, unsigned connection_index, std::vector<Player> &players, Stats &stats)
+    {
+        Connection connection{co_await net::this_coro::executor, config};
+        for (size_t i = connection_index; i < players.size(); i += config.connections)
+        {
+            const std::string &map_id = config.maps[i % config.maps.size()];
+            const std::string body = json::serialize(json::object{{"userName", "bot" + std::to_string(i)}, {"mapId", map_id}});
+            auto req = MakeRequest(config, http::verb::post, "/api/v1/game/join"sv, {}, body);
+            const auto start = Clock::now();
+            try
+            {
+                auto res = co_await connection.Send(req);
+                const bool ok = res.result() == http::status::ok;
+                stats.Add(Clock::now() - start, ok);
+                if (ok)
+                {
+                    players[i].token = json::parse(res.body()).as_object().at("authToken").as_string().c_str();
+                }
+            }
+            catch (const std::exception &)
+            {
+                stats.Add(Clock::now() - start, false);
+                connection.Close();
+            }
+        }
+    }
+
+    // Открытая модель нагрузки: запросы отправляются по расписанию, а задержка
+    // считается от запланированного момента отправки, чтобы отставание
+    // от графика не скрывало медленные ответы (coordinated omission)
+    net::awaitable<void> DriveLoad(const Config &config, unsigned connection_index, const std::vector<Player> &players,
+                                   Clock::time_point start, StatsTable &stats)
+    {
+        auto executor = co_await net::this_coro::executor;
+        Connection connection{executor, config};
+        net::steady_timer timer{executor};
+        std::mt19937 random{connection_index};
+        std::discrete_distribution<size_t> kind_dist(config.weights.begin(), config.weights.end());
+        std::uniform_int_distribution<size_t> player_dist(0, players.size() - 1);
+        std::uniform_int_distribution<int> move_dist(0, 4);
+        constexpr std::array<std::string_view, 5> moves = {"U"sv, "D"sv, "L"sv, "R"sv, ""sv};
+
+        const auto interval = std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(config.connections / config.rps));
+        const auto end = start + config.duration;
+        auto next = start + interval * connection_index / config.connections;
+
+        while (next < end)
+        {
+            timer.expires_at(next);
+            co_await timer.async_wait(net::use_awaitable);
+
+            const auto kind = static_cast<Kind>(kind_dist(random));
+            const std::string &token = players[player_dist(random)].token;
+            http::request<http::string_body> req;
+            switch (kind)
+            {
+            case Kind::ACTION:
+                req = MakeRequest(config, http::verb::post, "/api/v1/game/player/action"sv, token,
+                                  "{\"move\":\""s + std::string(moves[move_dist(random)]) + "\"}");
+                break;
+            case Kind::STATE:
+                req = MakeRequest(config, http::verb::get, "/api/v1/game/state"sv, token);
+                break;
+            case Kind::PLAYERS:
+                req = MakeRequest(config, http::verb::get, "/api/v1/game/players"sv, token);
+                break;
+            case Kind::RECORDS:
+                req = MakeRequest(config, http::verb::get, "/api/v1/game/records?start=0&maxItems=10"sv);
+                break;
+            default:
+                req = MakeRequest(config, http::verb::get, "/api/v1/maps"sv);
+                break;
+            }
+
+            bool ok = false;
+            try
+            {
+                auto res = co_await connection.Send(req);
+                ok = res.result_int() < 400;
+            }
+            catch (const std::exception &)
+            {
+                connection.Close();
+            }
+            stats[static_cast<size_t>(kind)].Add(Clock::now() - next, ok);
+            next += interval;
+        }
+    }
+
+    template <typename Fn>
+    void RunWorkers(unsigned n, const Fn &fn)
+    {
+        n = std::max(1u, n);
+        std::vector<std::thread> workers;
+        workers.reserve(n - 1);
+        while (--n)
+        {
+            workers.emplace_back(fn);
+        }
+        fn();
+        for (auto &worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    std::optional<std::array<double, KIND_COUNT>> ParseMix(const std::string &mix)
+    {
+        std::array<double, KIND_COUNT> weights{};
+        std::istringstream iss(mix);
+        for (std::string item; std::getline(iss, item, ',');)
+        {
+            const auto eq = item.find('=');
+            if (eq == std::string::npos)
+            {
+                return std::nullopt;
+            }
+            const auto it = std::find(KIND_NAMES.begin(), KIND_NAMES.end(), std::string_view(item).substr(0, eq));
+            if (it == KIND_NAMES.end() || *it == "join"sv)
+            {
+                return std::nullopt;
+            }
+            weights[it - KIND_NAMES.begin()] = std::stod(item.substr(eq + 1));
+        }
+        return weights;
+    }
+
+    void PrintReport(const StatsTable &stats, double seconds)
+    {
+        std::printf("%-8s %10s %8s %10s %9s %9s %9s %9s %9s\n",
+                    "endpoint", "requests", "errors", "rps", "p50,ms", "p90,ms", "p99,ms", "p99.9,ms", "max,ms");
+        Stats total;
+        for (size_t i = 0; i < KIND_COUNT; ++i)
+        {
+            const Stats &s = stats[i];
+            if (s.count == 0)
+            {
+                continue;
+            }
+            if (static_cast<Kind>(i) != Kind::JOIN)
+            {
+                total.Merge(s);
+            }
+            std::printf("%-8s %10llu %8llu %10.1f %9.3f %9.3f %9.3f %9.3f %9.3f\n",
+                        std::string(KIND_NAMES[i]).c_str(),
+                        static_cast<unsigned long long>(s.count), static_cast<unsigned long long>(s.errors),
+                        static_cast<Kind>(i) == Kind::JOIN ? 0.0 : s.count / seconds,
+                        s.Percentile(0.5) / 1e3, s.Percentile(0.9) / 1e3, s.Percentile(0.99) / 1e3,
+                        s.Percentile(0.999) / 1e3, s.max_us / 1e3);
+        }
+        std::printf("%-8s %10llu %8llu %10.1f %9.3f %9.3f %9.3f %9.3f %9.3f\n", "total",
+                    static_cast<unsigned long long>(total.count), static_cast<unsigned long long>(total.errors),
+                    total.count / seconds, total.Percentile(0.5) / 1e3, total.Percentile(0.9) / 1e3,
+                    total.Percentile(0.99) / 1e3, total.Percentile(0.999) / 1e3, total.max_us / 1e3);
+    }
+} // namespace
+
+int main(int argc, const char *argv[])
+{
+    namespace po = boost::program_options;
+
+    Config config;
+    po::options_description desc("Allowed options");
+    desc.add_options()("help,h", "produce help message")("host", po::value(&config.host), "server address")("port", po::value(&config.port), "server port")("players,n", po::value(&config.players), "number of players to join")("map", po::value<std::vector<std::string>>(), "map id to join, may be repeated")("connections,c", po::value(&config.connections), "keep-alive connections")("rps,r", po::value(&config.rps), "target requests per second")("duration,d", po::value<int>(), "load duration in seconds")("mix", po::value<std::string>(), "request mix, e.g. action=60,state=30,players=5,records=5,maps=0")("threads", po::value(&config.threads), "io threads");
+
+    po::variables_map vm;
+    try
+    {
+        po::store(po::parse_command_line(argc, argv, desc), vm);
+        po::notify(vm);
+    }
+    catch (const std::exception &ex)
+    {
+        std::cerr << "Error parsing command line: " << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (vm.count("help"))
+    {
+        std::cout << desc << std::endl;
+        return EXIT_SUCCESS;
+    }
+    if (vm.count("map"))
+    {
+        config.maps = vm["map"].as<std::vector<std::string>>();
+    }
+    if (vm.count("duration"))
+    {
+        config.duration = std::chrono::seconds(vm["duration"].as<int>());
+    }
+    if (vm.count("mix"))
+    {
+        auto weights = ParseMix(vm["mix"].as<std::string>());
+        if (!weights)
+        {
+            std::cerr << "Invalid request mix" << std::endl;
+            return EXIT_FAILURE;
+        }
+        config.weights = *weights;
+    }
+    if (config.players == 0 || config.connections == 0 || config.rps <= 0.0 || config.maps.empty())
+    {
+        std::cerr << "players, connections and rps must be positive" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Каждое соединение работает в своём strand, поэтому статистику
+    // можно вести без синхронизации и сложить в конце
+    std::vector<StatsTable> stats(config.connections);
+    std::vector<Player> players(config.players);
+    net::io_context ioc(config.threads);
+
+    for (unsigned i = 0; i < config.connections; ++i)
+    {
+        net::co_spawn(net::make_strand(ioc), JoinPlayers(config, i, players, stats[i][static_cast<size_t>(Kind::JOIN)]), net::detached);
+    }
+    RunWorkers(config.threads, [&ioc]
+               { ioc.run(); });
+
+    std::erase_if(players, [](const Player &player)
+                  { return player.token.empty(); });
+    if (players.empty())
+    {
+        std::cerr << "No player has joined the game" << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::cerr << "Joined " << players.size() << " players, running load for " << config.duration.count() << "s" << std::endl;
+
+    ioc.restart();
+    const auto start = Clock::now();
+    for (unsigned i = 0; i < config.connections; ++i)
+    {
+        net::co_spawn(net::make_strand(ioc), DriveLoad(config, i, players, start, stats[i]), net::detached);
+    }
+    RunWorkers(config.threads, [&ioc]
+               { ioc.run(); });
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    StatsTable total;
+    for (const auto &table : stats)
+    {
+        for (size_t i = 0; i < KIND_COUNT; ++i)
+        {
+            total[i].Merge(table[i]);
+        }
+    }
+    PrintReport(total, seconds);
+    return EXIT_SUCCESS;
+}
@@ -15,10 +15,17 @@
 #include <thread>
 #include <vector>
 #include <filesystem>
+#include <memory>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
 #include "http_server.h"
+#include "coro_http_server.h"
 #include "json_loader.h"
 #include "request_handler.h"
 #include "connection_pool.h"
+#include "file_io.h"
 
 using namespace std::literals;
 namespace net = boost::asio;
@@ -46,6 +53,38 @@ namespace
             worker.join();
         }
     }
+
+    // Закрепляет поток за ядром. Там, где это не поддерживается, ничего не делает
+    void PinToCore(std::thread &thread, unsigned core)
+    {
+#ifdef __linux__
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(core, &cpus);
+        pthread_setaffinity_np(thread.native_handle(), sizeof(cpus), &cpus);
+#else
+        (void)thread;
+        (void)core;
+#endif
+    }
+
+    // По одному потоку на каждый io_context, i-й поток закреплён за i-м ядром
+    void RunPinnedWorkers(const std::vector<std::unique_ptr<net::io_context>> &contexts)
+    {
+        const unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+        std::vector<std::thread> workers;
+        workers.reserve(contexts.size());
+        for (size_t i = 0; i < contexts.size(); ++i)
+        {
+            workers.emplace_back([&ioc = *contexts[i]]
+                                 { ioc.run(); });
+            PinToCore(workers.back(), static_cast<unsigned>(i % cores));
+        }
+        for (auto &worker : workers)
+        {
+            worker.join();
+        }
+    }
 }
 
 int main(int argc, const char *argv[])
@@ -53,7 +92,7 @@ int main(int argc, const char *argv[])
     namespace po = boost::program_options;
 
     po::options_description desc("Allowed options");
-    desc.add_options()("help,h", "produce help message")("tick-period,t", po::value<int>(), "milliseconds set tick period")("config-file,c", po::value<std::string>(), "file set config file path")("www-root,w", po::value<std::string>(), "dir set static files root")("state-file", po::value<std::string>(), "path to game state file")("save-state-period", po::value<int>(), "save interval in ms")("randomize-spawn-points", "spawn dogs at random positions");
+    desc.add_options()("help,h", "produce help message")("tick-period,t", po::value<int>(), "milliseconds set tick period")("config-file,c", po::value<std::string>(), "file set config file path")("www-root,w", po::value<std::string>(), "dir set static files root")("state-file", po::value<std::string>(), "path to game state file")("save-state-period", po::value<int>(), "save interval in ms")("randomize-spawn-points", "spawn dogs at random positions")("log-level", po::value<std::string>(), "minimal log severity (trace, debug, info, warning, error, fatal)")("log-sample", po::value<unsigned>(), "log every N-th request (0 disables request logging)")("log-queue-size", po::value<size_t>(), "max log records waiting to be written")("max-players-per-session", po::value<size_t>(), "max players in one session instance (0 means unlimited)")("bots-per-map", po::value<size_t>(), "keep N server-side bot players on every map")("bot-policy", po::value<std::string>(), "bot behaviour: wander or collect")("coro-sessions", "serve connections with coroutine-based sessions")("io-contexts", po::value<unsigned>(), "run N single-threaded io_contexts pinned to cores, each with its own SO_REUSEPORT listener (0 means one shared io_context)")("io-uring", "read static files and write state snapshots through io_uring (needs a build with GAME_SERVER_IO_URING)");
 
     po::variables_map vm;
     try
@@ -94,10 +133,58 @@ int main(int argc, const char *argv[])
     const std::string config_file = vm["config-file"].as<std::string>();
     const std::string www_root = vm["www-root"].as<std::string>();
     const bool randomize_spawn = vm.count("randomize-spawn-points") > 0;
+    const size_t max_players_per_session = vm.count("max-players-per-session") ? vm["max-players-per-session"].as<size_t>() : 0;
+    const bool coro_sessions = vm.count("coro-sessions") > 0;
+    const unsigned io_contexts = vm.count("io-contexts") ? vm["io-contexts"].as<unsigned>() : 0;
+    // Механизм сокетов Asio выбирается при сборке, поэтому флаг включает только файловые операции
+    const bool io_uring = vm.count("io-uring") > 0;
+    if (io_uring && !file_io::IsAsync())
+    {
+        std::cerr << "This build has no io_uring support, rebuild with -DGAME_SERVER_IO_URING=ON" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    bots::Settings bot_settings;
+    if (vm.count("bots-per-map"))
+    {
+        bot_settings.bots_per_map = vm["bots-per-map"].as<size_t>();
+    }
+    if (vm.count("bot-policy"))
+    {
+        const std::string policy = vm["bot-policy"].as<std::string>();
+        const auto parsed = bots::ParsePolicy(policy);
+        if (!parsed)
+        {
+            std::cerr << "Unknown bot policy: " << policy << std::endl;
+            return EXIT_FAILURE;
+        }
+        bot_settings.policy = *parsed;
+    }
+
+    async_log::SinkSettings log_settings;
+    if (vm.count("log-level"))
+    {
+        const std::string level = vm["log-level"].as<std::string>();
+        if (!logging::trivial::from_string(level.c_str(), level.size(), log_settings.min_level))
+        {
+            std::cerr << "Unknown log level: " << level << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    if (vm.count("log-sample"))
+    {
+        log_settings.sample_every = vm["log-sample"].as<unsigned>();
+    }
+    if (vm.count("log-queue-size"))
+    {
+        log_settings.queue_capacity = vm["log-queue-size"].as<size_t>();
+    }
+    // Записи о запросах имеют уровень info: ниже него их незачем даже собирать
+    const unsigned request_sample_every = log_settings.min_level <= logging::trivial::info ? log_settings.sample_every : 0;
 
     try
     {
-        http_handler::InitLogging();
+        http_handler::InitLogging(log_settings);
 
         model::Game game = json_loader::LoadGame(config_file);
         const char *db_url = std::getenv("GAME_DB_URL");
@@ -116,19 +203,37 @@ int main(int argc, const char *argv[])
         auto record_repo = std::make_shared<database::RecordRepository>(db_pool);
 
         const unsigned num_threads = std::thread::hardware_concurrency();
-        net::io_context ioc(num_threads);
+        // Обычно все потоки делят один io_context. В режиме --io-contexts у каждого ядра
+        // свой io_context и свой слушающий сокет. Запросы к игре уходят в strand игры
+        // в первом из них, запросы к базе — в пул блокирующих задач обработчика,
+        // а запись ответа всегда возвращается в исполнитель сессии
+        std::vector<std::unique_ptr<net::io_context>> contexts;
+        if (io_contexts == 0)
+        {
+            contexts.push_back(std::make_unique<net::io_context>(num_threads));
+        }
+        else
+        {
+            for (unsigned i = 0; i < io_contexts; ++i)
+            {
+                contexts.push_back(std::make_unique<net::io_context>(1));
+            }
+        }
+        net::io_context &ioc = *contexts.front();
 
         net::signal_set signals(ioc, SIGINT, SIGTERM);
-        signals.async_wait([&ioc](const sys::error_code &ec, int)
+        signals.async_wait([&contexts](const sys::error_code &ec, int)
                            {
             if (!ec) {
-                ioc.stop();
+                for (auto &context : contexts) {
+                    context->stop();
+                }
             } });
 
         auto static_root = www_root;
         net::strand<net::io_context::executor_type> api_strand = net::make_strand(ioc);
-        http_handler::RequestHandler handler{game, static_root, api_strand, randomize_spawn, state_file_path, save_period, record_repo};
-        http_handler::LoggingRequestHandler logging_handler{handler};
+        http_handler::RequestHandler handler{game, static_root, api_strand, randomize_spawn, state_file_path, save_period, record_repo, max_players_per_session, bot_settings, io_uring};
+        http_handler::LoggingRequestHandler logging_handler{handler, request_sample_every};
 
         std::shared_ptr<http_handler::Ticker> ticker = nullptr;
         if (tick_period)
@@ -149,20 +254,45 @@ int main(int argc, const char *argv[])
         json::object start_data;
         start_data["port"] = port;
         start_data["address"] = address.to_string();
+#ifdef BOOST_ASIO_HAS_IO_URING
+        start_data["io_backend"] = "io_uring";
+#else
+        start_data["io_backend"] = "epoll";
+#endif
         BOOST_LOG_TRIVIAL(info) << logging::add_value(additional_data, start_data) << "server started";
 
-        http_server::ServeHttp(ioc, {address, port},
-                               [&logging_handler](auto &&req, auto &&send, const std::string &ip)
-                               {
-                                   logging_handler(std::forward<decltype(req)>(req),
-                                                   std::forward<decltype(send)>(send),
-                                                   ip);
-                               });
+        const auto serve_request = [&logging_handler](auto &&req, auto &&send, const std::string &ip)
+        {
+            logging_handler(std::forward<decltype(req)>(req),
+                            std::forward<decltype(send)>(send),
+                            ip);
+        };
+        // Обе реализации сессий обслуживают один и тот же обработчик, чтобы их можно было сравнить
+        const bool share_port = io_contexts > 0;
+        for (auto &context : contexts)
+        {
+            if (coro_sessions)
+            {
+                http_server::ServeHttpCoro(*context, {address, port}, serve_request, share_port);
+            }
+            else
+            {
+                http_server::ServeHttp(*context, {address, port}, serve_request, share_port);
+            }
+        }
 
-        RunWorkers(num_threads, [&ioc]
-                   { ioc.run(); });
+        if (io_contexts == 0)
+        {
+            RunWorkers(num_threads, [&ioc]
+                       { ioc.run(); });
+        }
+        else
+        {
+            RunPinnedWorkers(contexts);
+        }
         handler.GetApiHandler().SaveState();
         BOOST_LOG_TRIVIAL(info) << logging::add_value(additional_data, json::value{{"code", 0}}) << "server exited";
+        http_handler::ShutdownLogging();
         return 0;
     }
     catch (const std::exception &ex)
@@ -171,6 +301,7 @@ int main(int argc, const char *argv[])
         error_data["code"] = EXIT_FAILURE;
         error_data["exception"] = ex.what();
         BOOST_LOG_TRIVIAL(info) << logging::add_value(additional_data, error_data) << "server exited";
+        http_handler::ShutdownLogging();
         return EXIT_FAILURE;
     }
 }
@@ -0,0 +1,263 @@
+#include "metrics.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace metrics
+{
+
+    namespace
+    {
+        using namespace std::literals;
+
+        struct HistogramData
+        {
+            std::array<std::atomic<uint64_t>, Buckets::COUNT> buckets{};
+            std::atomic<uint64_t> sum{0};
+            std::atomic<uint64_t> count{0};
+        };
+
+        // Данные одного потока. Пишет в них только поток-владелец, поэтому
+        // вместо атомарного инкремента достаточно relaxed load + store;
+        // atomic нужен лишь для того, чтобы чтение при экспорте не было гонкой.
+        struct Shard
+        {
+            std::array<HistogramData, static_cast<size_t>(Timer::COUNT)> timers;
+            std::array<HistogramData, ROUTE_COUNT> routes;
+            std::array<std::atomic<int64_t>, static_cast<size_t>(Counter::COUNT)> counters{};
+        };
+
+        template <typename T>
+        void Bump(std::atomic<T> &value, T delta) noexcept
+        {
+            value.store(value.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+        }
+
+        void Record(HistogramData &data, std::chrono::nanoseconds duration) noexcept
+        {
+            const auto us = static_cast<uint64_t>(std::max<int64_t>(
+                std::chrono::duration_cast<std::chrono::microseconds>(duration).count(), 0));
+            Bump(data.buckets[Buckets::Index(us)], uint64_t{1});
+            Bump(data.sum, us);
+            Bump(data.count, uint64_t{1});
+        }
+
+        class Registry
+        {
+        public:
+            Shard *AddShard()
+            {
+                std::lock_guard lock{mutex_};
+                // Потоки могут завершиться раньше экспорта, поэтому шарды
+                // принадлежат реестру и живут до конца программы
+                return shards_.emplace_back(std::make_unique<Shard>()).get();
+            }
+
+            template <typename Fn>
+            void ForEachShard(Fn &&fn) const
+            {
+                std::lock_guard lock{mutex_};
+                for (const auto &shard : shards_)
+                {
+                    fn(*shard);
+                }
+            }
+
+        private:
+            mutable std::mutex mutex_;
+            std::vector<std::unique_ptr<Shard>> shards_;
+        };
+
+        Registry &GetRegistry()
+        {
+            static Registry registry;
+            return registry;
+        }
+
+        Shard &LocalShard()
+        {
+            thread_local Shard *shard = GetRegistry().AddShard();
+            return *shard;
+        }
+
+        struct Totals
+        {
+            std::array<uint64_t, Buckets::COUNT> buckets{};
+            uint64_t sum = 0;
+            uint64_t count = 0;
+        };
+
+        template <typename Select>
+        Totals Collect(Select &&select)
+        {
+            Totals totals;
+            GetRegistry().ForEachShard([&](const Shard &shard)
+                                       {
+                const HistogramData &data = select(shard);
+                for (size_t i = 0; i < Buckets::COUNT; ++i) {
+                    totals.buckets[i] += data.buckets[i].load(std::memory_order_relaxed);
+                }
+                totals.sum += data.sum.load(std::memory_order_relaxed);
+                totals.count += data.count.load(std::memory_order_relaxed); });
+            return totals;
+        }
+
+        std::string FormatSeconds(uint64_t us)
+        {
+            char buf[32];
+            std::snprintf(buf, sizeof(buf), "%.9g", static_cast<double>(us) / 1e6);
+            return buf;
+        }
+
+        // Выводятся только корзины до последней непустой — этого достаточно
+        // для вычисления квантилей и не раздувает ответ на сотни строк
+        void WriteHistogram(std::string &out, std::string_view name, std::string_view labels, const Totals &totals)
+        {
+            const std::string prefix = labels.empty() ? "{"s : "{"s + std::string(labels) + ",";
+            size_t last = 0;
+            for (size_t i = 0; i < Buckets::COUNT; ++i)
+            {
+                if (totals.buckets[i] != 0)
+                {
+                    last = i + 1;
+                }
+            }
+            uint64_t cumulative = 0;
+            for (size_t i = 0; i < last; ++i)
+            {
+                cumulative += totals.buckets[i];
+                out.append(name).append("_bucket").append(prefix);
+                out.append("le=\"").append(FormatSeconds(Buckets::UpperBound(i))).append("\"} ");
+                out.append(std::to_string(cumulative)).append("\n");
+            }
+            out.append(name).append("_bucket").append(prefix).append("le=\"+Inf\"} ");
+            out.append(std::to_string(totals.count)).append("\n");
+            const std::string suffix = labels.empty() ? ""s : "{"s + std::string(labels) + "}";
+            out.append(name).append("_sum").append(suffix).append(" ").append(FormatSeconds(totals.sum)).append("\n");
+            out.append(name).append("_count").append(suffix).append(" ").append(std::to_string(totals.count)).append("\n");
+        }
+
+        void WriteHeader(std::string &out, std::string_view name, std::string_view type, std::string_view help)
+        {
+            out.append("# HELP ").append(name).append(" ").append(help).append("\n");
+            out.append("# TYPE ").append(name).append(" ").append(type).append("\n");
+        }
+
+        std::string_view RouteName(size_t route)
+        {
+            using api_router::Endpoint;
+            if (route == STATIC_ROUTE)
+            {
+                return "static"sv;
+            }
+            if (route >= api_router::ENDPOINT_COUNT)
+            {
+                return "unknown"sv;
+            }
+            switch (static_cast<Endpoint>(route))
+            {
+            case Endpoint::MAPS:
+                return "maps"sv;
+            case Endpoint::MAP_BY_ID:
+                return "map_by_id"sv;
+            case Endpoint::JOIN:
+                return "join"sv;
+            case Endpoint::PLAYERS:
+                return "players"sv;
+            case Endpoint::STATE:
+                return "state"sv;
+            case Endpoint::ACTION:
+                return "action"sv;
+            case Endpoint::ACTIONS:
+                return "actions"sv;
+            case Endpoint::TICK:
+                return "tick"sv;
+            case Endpoint::RECORDS:
+                return "records"sv;
+            case Endpoint::METRICS:
+                return "metrics"sv;
+            }
+            return "unknown"sv;
+        }
+
+        Totals CollectTimer(Timer timer)
+        {
+            return Collect([timer](const Shard &shard) -> const HistogramData &
+                           { return shard.timers[static_cast<size_t>(timer)]; });
+        }
+
+        int64_t CollectCounter(Counter counter)
+        {
+            int64_t total = 0;
+            GetRegistry().ForEachShard([&](const Shard &shard)
+                                       { total += shard.counters[static_cast<size_t>(counter)].load(std::memory_order_relaxed); });
+            return total;
+        }
+    } // namespace
+
+    void Observe(Timer timer, std::chrono::nanoseconds duration) noexcept
+    {
+        Record(LocalShard().timers[static_cast<size_t>(timer)], duration);
+    }
+
+    void ObserveRequest(size_t route, std::chrono::nanoseconds duration) noexcept
+    {
+        Record(LocalShard().routes[std::min(route, UNKNOWN_ROUTE)], duration);
+    }
+
+    void Add(Counter counter, int64_t delta) noexcept
+    {
+        Bump(LocalShard().counters[static_cast<size_t>(counter)], delta);
+    }
+
+    std::string RenderPrometheus()
+    {
+        std::string out;
+
+        WriteHeader(out, "game_http_request_duration_seconds"sv, "histogram"sv, "Time from request receipt to response by route"sv);
+        for (size_t route = 0; route < ROUTE_COUNT; ++route)
+        {
+            const Totals totals = Collect([route](const Shard &shard) -> const HistogramData &
+                                          { return shard.routes[route]; });
+            WriteHistogram(out, "game_http_request_duration_seconds"sv, "route=\""s + std::string(RouteName(route)) + "\"", totals);
+        }
+
+        constexpr std::pair<Timer, std::string_view> tick_phases[] = {
+            {Timer::TICK, "total"sv},
+            {Timer::TICK_BOTS, "bots"sv},
+            {Timer::TICK_MOVE, "move"sv},
+            {Timer::TICK_GATHER, "gather"sv},
+            {Timer::TICK_RETIRE, "retire"sv},
+            {Timer::TICK_LOOT_SPAWN, "loot_spawn"sv},
+            {Timer::TICK_SAVE, "save"sv},
+            {Timer::TICK_STATE_CACHE, "state_cache"sv},
+        };
+        WriteHeader(out, "game_tick_duration_seconds"sv, "histogram"sv, "Game tick duration by phase"sv);
+        for (const auto &[timer, phase] : tick_phases)
+        {
+            WriteHistogram(out, "game_tick_duration_seconds"sv, "phase=\""s + std::string(phase) + "\"", CollectTimer(timer));
+        }
+
+        WriteHeader(out, "game_strand_wait_seconds"sv, "histogram"sv, "Time a request waits in the game strand queue"sv);
+        WriteHistogram(out, "game_strand_wait_seconds"sv, ""sv, CollectTimer(Timer::STRAND_WAIT));
+
+        WriteHeader(out, "game_db_pool_wait_seconds"sv, "histogram"sv, "Time spent waiting for a database connection"sv);
+        WriteHistogram(out, "game_db_pool_wait_seconds"sv, ""sv, CollectTimer(Timer::DB_POOL_WAIT));
+
+        WriteHeader(out, "game_snapshot_duration_seconds"sv, "histogram"sv, "Game state snapshot duration"sv);
+        WriteHistogram(out, "game_snapshot_duration_seconds"sv, ""sv, CollectTimer(Timer::SNAPSHOT));
+
+        WriteHeader(out, "game_tick_errors_total"sv, "counter"sv, "Exceptions thrown by tick handler"sv);
+        out.append("game_tick_errors_total ").append(std::to_string(CollectCounter(Counter::TICK_ERRORS))).append("\n");
+
+        WriteHeader(out, "game_active_connections"sv, "gauge"sv, "Open HTTP connections"sv);
+        out.append("game_active_connections ").append(std::to_string(CollectCounter(Counter::ACTIVE_CONNECTIONS))).append("\n");
+
+        return out;
+    }
+
+} // namespace metrics
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "api_router.h"
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace metrics
+{
+
+    enum class Timer : size_t
+    {
+        TICK,
+        TICK_BOTS,
+        TICK_MOVE,
+        TICK_GATHER,
+        TICK_RETIRE,
+        TICK_LOOT_SPAWN,
+        TICK_SAVE,
+        TICK_STATE_CACHE,
+        STRAND_WAIT,
+        DB_POOL_WAIT,
+        SNAPSHOT,
+        COUNT
+    };
+
+    enum class Counter : size_t
+    {
+        TICK_ERRORS,
+        ACTIVE_CONNECTIONS,
+        COUNT
+    };
+
+    // Маршруты API, затем статика и нераспознанные запросы
+    inline constexpr size_t STATIC_ROUTE = api_router::ENDPOINT_COUNT;
+    inline constexpr size_t UNKNOWN_ROUTE = STATIC_ROUTE + 1;
+    inline constexpr size_t ROUTE_COUNT = UNKNOWN_ROUTE + 1;
+
+    // Логарифмически-линейные корзины, как в HdrHistogram: на каждую
+    // степень двойки приходится 8 корзин, погрешность не больше 12.5%.
+    // Значения измеряются в микросекундах.
+    struct Buckets
+    {
+        static constexpr unsigned SUB_BITS = 3;
+        static constexpr size_t SUB_COUNT = size_t{1} << SUB_BITS;
+        static constexpr unsigned MAX_EXPONENT = 40;
+        static constexpr size_t COUNT = (MAX_EXPONENT - SUB_BITS + 2) * SUB_COUNT;
+
+        static constexpr size_t Index(uint64_t value) noexcept
+        {
+            if (value < SUB_COUNT)
+            {
+                return static_cast<size_t>(value);
+            }
+            const unsigned exponent = static_cast<unsigned>(std::bit_width(value)) - 1;
+            if (exponent > MAX_EXPONENT)
+            {
+                return COUNT - 1;
+            }
+            const size_t sub = (value >> (exponent - SUB_BITS)) & (SUB_COUNT - 1);
+            return (exponent - SUB_BITS + 1) * SUB_COUNT + sub;
+        }
+
+        // Наибольшее значение, попадающее в корзину
+        static constexpr uint64_t UpperBound(size_t index) noexcept
+        {
+            if (index < SUB_COUNT)
+            {
+                return index;
+            }
+            const unsigned exponent = static_cast<unsigned>(index / SUB_COUNT) + SUB_BITS - 1;
+            const uint64_t sub = index % SUB_COUNT;
+            return ((SUB_COUNT + sub + 1) << (exponent - SUB_BITS)) - 1;
+        }
+    };
+
+    static_assert(Buckets::Index(Buckets::UpperBound(100)) == 100);
+    static_assert(Buckets::Index(Buckets::UpperBound(100) + 1) == 101);
+
+    void Observe(Timer timer, std::chrono::nanoseconds duration) noexcept;
+    void ObserveRequest(size_t route, std::chrono::nanoseconds duration) noexcept;
+    void Add(Counter counter, int64_t delta = 1) noexcept;
+
+    // Текст в формате Prometheus (text exposition format 0.0.4)
+    std::string RenderPrometheus();
+
+    // match — результат api_router::Match для той же цели, чтобы не разбирать её повторно
+    inline size_t RouteIndex(std::string_view target, const api_router::RouteMatch &match) noexcept
+    {
+        using namespace std::literals;
+        if (!target.starts_with("/api/"sv))
+        {
+            return STATIC_ROUTE;
+        }
+        return match ? static_cast<size_t>(match.route->endpoint) : UNKNOWN_ROUTE;
+    }
+
+    class ScopedTimer
+    {
+    public:
+        explicit ScopedTimer(Timer timer) noexcept
+            : timer_{timer}, start_{std::chrono::steady_clock::now()}
+        {
+        }
+
+        ScopedTimer(const ScopedTimer &) = delete;
+        ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+        ~ScopedTimer()
+        {
+            Observe(timer_, std::chrono::steady_clock::now() - start_);
+        }
+
+    private:
+        Timer timer_;
+        std::chrono::steady_clock::time_point start_;
+    };
+
+} // namespace metrics
@@ -1,10 +1,44 @@
 #include "model.h"
 
+#include <algorithm>
 #include <stdexcept>
 
 namespace model {
 using namespace std::literals;
 
+void Map::AddRoad(const Road& road) {
+    const Point start = road.GetStart();
+    const Point end = road.GetEnd();
+    const double length = std::max(std::abs(end.x - start.x), std::abs(end.y - start.y));
+    road_length_prefix_.push_back(GetTotalRoadLength() + length);
+    roads_.emplace_back(road);
+    road_index_.AddRoad(roads_.back(), roads_.size() - 1);
+}
+
+Position Map::GetPointAtRoadDistance(double distance) const {
+    if (roads_.empty()) {
+        throw std::runtime_error("No roads available");
+    }
+    // Первая дорога, на которой накопленная длина превышает distance.
+    // Дороги нулевой длины при этом пропускаются сами собой
+    auto it = std::upper_bound(road_length_prefix_.begin(), road_length_prefix_.end(), distance);
+    if (it == road_length_prefix_.end()) {
+        it = std::prev(it);
+    }
+    const size_t index = static_cast<size_t>(it - road_length_prefix_.begin());
+    const double road_begin = index == 0 ? 0.0 : road_length_prefix_[index - 1];
+    const Road& road = roads_[index];
+    const Point start = road.GetStart();
+    const Point end = road.GetEnd();
+    const double offset = std::clamp(distance - road_begin, 0.0, *it - road_begin);
+    if (road.IsHorizontal()) {
+        const double dir = end.x >= start.x ? 1.0 : -1.0;
+        return {start.x + dir * offset, static_cast<double>(start.y)};
+    }
+    const double dir = end.y >= start.y ? 1.0 : -1.0;
+    return {static_cast<double>(start.x), start.y + dir * offset};
+}
+
 void Map::AddOffice(Office office) {
     if (warehouse_id_to_index_.contains(office.GetId())) {
         throw std::invalid_argument("Duplicate warehouse");
@@ -27,6 +61,7 @@ void Game::AddMap(Map map) {
         throw std::invalid_argument("Map with id "s + *map.GetId() + " already exists"s);
     } else {
         try {
+            map.index_ = index;
             maps_.emplace_back(std::move(map));
         } catch (...) {
             map_id_to_index_.erase(it);
@@ -34,12 +69,24 @@ void Game::AddMap(Map map) {
         }
     }
 }
-void Map::SetLootTypeCount(int count) {
-    loot_type_count_ = count;
+void Map::SetLootTypes(LootTypes loot_types) {
+    loot_types_ = std::move(loot_types);
+    loot_weight_prefix_.clear();
+    uint64_t total = 0;
+    for (const LootType& loot_type : loot_types_) {
+        total += loot_type.weight;
+        loot_weight_prefix_.push_back(total);
+    }
 }
 
-int Map::GetLootTypeCount() const {
-    return loot_type_count_;
+int Map::PickLootType(double fraction) const {
+    if (loot_types_.empty()) {
+        throw std::runtime_error("No loot types available");
+    }
+    const uint64_t total = loot_weight_prefix_.back();
+    const auto target = std::min(static_cast<uint64_t>(fraction * static_cast<double>(total)), total - 1);
+    const auto it = std::upper_bound(loot_weight_prefix_.begin(), loot_weight_prefix_.end(), target);
+    return static_cast<int>(it - loot_weight_prefix_.begin());
 }
 
 void Map::SetLootGenerator(loot_gen::LootGenerator generator) {
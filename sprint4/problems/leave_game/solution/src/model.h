@@ -3,8 +3,9 @@
 #include <unordered_map>
 #include <vector>
 #include <cmath>
-#include <list>
+#include <cstdint>
 #include <optional>
+#include <utility>
 
 #include "tagged.h"
 #include "loot_generator.h"
@@ -161,15 +162,23 @@ namespace model
         Offset offset_;
     };
 
+    // Тип трофея, разобранный из конфига при загрузке карты
+    struct LootType
+    {
+        int value = 0;
+        unsigned weight = 1;
+    };
+
     class Map
     {
         class RoadIndex;
 
     public:
         using Id = util::Tagged<std::string, Map>;
-        using Roads = std::list<Road>;
+        using Roads = std::vector<Road>;
         using Buildings = std::vector<Building>;
         using Offices = std::vector<Office>;
+        using LootTypes = std::vector<LootType>;
 
         Map(Id id, std::string name) noexcept
             : id_(std::move(id)), name_(std::move(name))
@@ -181,6 +190,12 @@ namespace model
             return id_;
         }
 
+        // Плотный номер карты в Game, назначается при добавлении карты в игру
+        size_t GetIndex() const noexcept
+        {
+            return index_;
+        }
+
         const std::string &GetName() const noexcept
         {
             return name_;
@@ -201,11 +216,7 @@ namespace model
             return offices_;
         }
 
-        void AddRoad(const Road &road)
-        {
-            roads_.emplace_back(road);
-            road_index_.AddRoad(roads_.back());
-        }
+        void AddRoad(const Road &road);
         const RoadIndex &GetRoadIndex() const noexcept
         {
             return road_index_;
@@ -224,8 +235,17 @@ namespace model
         }
         const Road *FindRoadAtPosition(Point pos, Orientation orientation) const
         {
-            return road_index_.FindRoadAtPosition(pos.x, pos.y, orientation);
+            return RoadByIndex(road_index_.FindRoadAtPosition(pos.x, pos.y, orientation));
         }
+        // Суммарная длина всех дорог карты
+        double GetTotalRoadLength() const noexcept
+        {
+            return road_length_prefix_.empty() ? 0.0 : road_length_prefix_.back();
+        }
+        // Точка на расстоянии distance от начала дорожной сети, если выложить
+        // все дороги одну за другой. Равномерное distance из [0, GetTotalRoadLength()]
+        // даёт равномерно распределённую по дорогам точку. O(log(число дорог))
+        Position GetPointAtRoadDistance(double distance) const;
         Position FitPositionToRoad(const Position &current_pos, const Position &new_pos) const
         {
             // 1. Определяем направление движения
@@ -235,13 +255,13 @@ namespace model
             Orientation movement_orientation = (std::abs(dx) > std::abs(dy)) ? Orientation::HORIZONTAL : Orientation::VERTICAL;
 
             // 2. Находим дорогу
-            const Road *road = road_index_.FindRoadAtPosition(current_pos.x, current_pos.y, movement_orientation);
+            const Road *road = RoadByIndex(road_index_.FindRoadAtPosition(current_pos.x, current_pos.y, movement_orientation));
 
             if (!road)
             {
-                road = road_index_.FindRoadAtPosition(current_pos.x, current_pos.y, movement_orientation == Orientation::HORIZONTAL
-                                                                       ? Orientation::VERTICAL
-                                                                       : Orientation::HORIZONTAL);
+                road = RoadByIndex(road_index_.FindRoadAtPosition(current_pos.x, current_pos.y, movement_orientation == Orientation::HORIZONTAL
+                                                                                  ? Orientation::VERTICAL
+                                                                                  : Orientation::HORIZONTAL));
                 if (!road)
                 {
                     return current_pos;
@@ -295,11 +315,24 @@ namespace model
             return bag_capacity_for_map_;
         }
         void AddOffice(Office office);
-        void SetLootTypeCount(int count);
-        int GetLootTypeCount() const;
+        void SetLootTypes(LootTypes loot_types);
+        const LootTypes &GetLootTypes() const noexcept
+        {
+            return loot_types_;
+        }
+        int GetLootTypeCount() const noexcept
+        {
+            return static_cast<int>(loot_types_.size());
+        }
+        // Индекс типа трофея с учётом весов. fraction — равномерное число из [0, 1)
+        int PickLootType(double fraction) const;
 
         void SetLootGenerator(loot_gen::LootGenerator generator);
         loot_gen::LootGenerator& GetLootGenerator();
+        bool HasLootGenerator() const noexcept
+        {
+            return loot_generator_.has_value();
+        }
         void SetRetirementTime(double time){
             retirement_time_ = time;
         }
@@ -307,10 +340,16 @@ namespace model
             return retirement_time_;
         }
     private:
+        friend class Game;
+
+        // Дороги хранятся в векторе, поэтому индекс ссылается на них по номеру,
+        // а не по указателю: указатели инвалидируются при росте вектора
         class RoadIndex
         {
         public:
-            void AddRoad(const Road &road)
+            static constexpr size_t NO_ROAD = static_cast<size_t>(-1);
+
+            void AddRoad(const Road &road, size_t road_index)
             {
                 if (road.IsHorizontal())
                 {
@@ -320,7 +359,7 @@ namespace model
                     for (int x = x1; x != x2 + step; x += step)
                     {
                         Point key{x, road.GetStart().y};
-                        point_to_road_[Orientation::HORIZONTAL][key] = &road;
+                        point_to_road_[Orientation::HORIZONTAL][key] = road_index;
                     }
                 }
                 else
@@ -331,37 +370,46 @@ namespace model
                     for (int y = y1; y != y2 + step; y += step)
                     {
                         Point key{road.GetStart().x, y};
-                        point_to_road_[Orientation::VERTICAL][key] = &road;
+                        point_to_road_[Orientation::VERTICAL][key] = road_index;
                     }
                 }
             }
 
-            const Road *FindRoadAtPosition(double x, double y, Orientation orientation) const
+            size_t FindRoadAtPosition(double x, double y, Orientation orientation) const
             {
                 Point key{static_cast<int>(std::round(x)), static_cast<int>(std::round(y))};
                 auto it_orient = point_to_road_.find(orientation);
                 if (it_orient == point_to_road_.end())
-                    return nullptr;
+                    return NO_ROAD;
                 const auto &road_map = it_orient->second;
                 auto it = road_map.find(key);
-                return (it != road_map.end()) ? it->second : nullptr;
+                return (it != road_map.end()) ? it->second : NO_ROAD;
             }
 
         private:
-            std::unordered_map<Orientation, std::unordered_map<Point, const Road *, PointHash>> point_to_road_;
+            std::unordered_map<Orientation, std::unordered_map<Point, size_t, PointHash>> point_to_road_;
         };
+        const Road *RoadByIndex(size_t index) const noexcept
+        {
+            return index == RoadIndex::NO_ROAD ? nullptr : &roads_[index];
+        }
         using OfficeIdToIndex = std::unordered_map<Office::Id, size_t, util::TaggedHasher<Office::Id>>;
         double speed_ = 1;
         double retirement_time_ = 60.0;
+        size_t index_ = 0;
         Id id_;
         std::string name_;
         Roads roads_;
+        // road_length_prefix_[i] — суммарная длина дорог с 0 по i включительно
+        std::vector<double> road_length_prefix_;
         Buildings buildings_;
         RoadIndex road_index_;
         double road_width_ = 0.8;
         OfficeIdToIndex warehouse_id_to_index_;
         Offices offices_;
-        int loot_type_count_ = 0;
+        LootTypes loot_types_;
+        // loot_weight_prefix_[i] — суммарный вес типов с 0 по i включительно
+        std::vector<uint64_t> loot_weight_prefix_;
         int bag_capacity_for_map_ = 3;
         std::optional<loot_gen::LootGenerator> loot_generator_;
     };
@@ -387,6 +435,22 @@ namespace model
             return nullptr;
         }
 
+        Map *FindMap(const Map::Id &id) noexcept
+        {
+            return const_cast<Map *>(std::as_const(*this).FindMap(id));
+        }
+
+        size_t GetMapCount() const noexcept
+        {
+            return maps_.size();
+        }
+
+        // Карта с индексом Map::GetIndex
+        Map &GetMapByIndex(size_t index) noexcept
+        {
+            return maps_[index];
+        }
+
     private:
         using MapIdHasher = util::TaggedHasher<Map::Id>;
         using MapIdToIndex = std::unordered_map<Map::Id, size_t, MapIdHasher>;
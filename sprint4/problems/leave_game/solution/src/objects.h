@@ -2,21 +2,24 @@
 
 #include "model.h"
 #include "collision_detector.h"
+#include "fast_random.h"
+#include "slot_map.h"
+#include "timer_wheel.h"
+#include "token.h"
 #include <random>
 #include <string>
-#include <sstream>
 #include <optional>
-#include <iomanip>
 #include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <numeric>
+#include <string_view>
 #include <chrono>
 #include <cmath>
-#include <set>
-#include <boost/json.hpp>
-
-struct TokenTag
-{
-};
-using Token = util::Tagged<std::string, TokenTag>;
+#include <vector>
 
 enum class Direction
 {
@@ -26,49 +29,44 @@ enum class Direction
     EAST
 };
 
-inline model::Position GetRandomPositionOnRoad(const model::Map &map)
+// Случайная точка, равномерно распределённая по всей длине дорог карты:
+// одно обращение к генератору и двоичный поиск по накопленным длинам дорог
+inline model::Position GetRandomPositionOnRoad(const model::Map &map, util::FastRandom &random)
 {
-    const auto &roads = map.GetRoads();
-    if (roads.empty())
+    if (map.GetRoads().empty())
     {
         throw std::runtime_error("No roads available");
     }
-
-    static thread_local std::mt19937 gen(std::random_device{}());
-    std::uniform_int_distribution<size_t> road_dist(0, roads.size() - 1);
-    const auto &road = *std::next(roads.begin(), road_dist(gen));
-
-    const auto &start = road.GetStart();
-    const auto &end = road.GetEnd();
-    int dx = end.x - start.x;
-    int dy = end.y - start.y;
-    int length = std::max(std::abs(dx), std::abs(dy));
-    if (length == 0)
-    {
-        throw std::runtime_error("Invalid road with zero length");
-    }
-
-    std::uniform_int_distribution<int> step_dist(0, length);
-    int step = step_dist(gen);
-
-    model::Point point = dx != 0
-                             ? model::Point{start.x + (dx > 0 ? step : -step), start.y}
-                             : model::Point{start.x, start.y + (dy > 0 ? step : -step)};
-    return {static_cast<double>(point.x), static_cast<double>(point.y)};
+    return map.GetPointAtRoadDistance(random.NextDouble() * map.GetTotalRoadLength());
 }
 
 class GameSession;
 
+// Сериализованное состояние сессии для ответов /game/state и /game/players.
+// Собирается один раз и отдаётся всем опрашивающим игрокам сессии
+struct SessionStateSnapshot
+{
+    std::string json;
+    std::string players;
+    // Сжатый json собирается вне strand первым запросом, который принимает gzip
+    mutable std::once_flag gzip_once;
+    mutable std::string gzip;
+};
+
 class Dog
 {
 public:
-    Dog(int id, const std::string &name, model::Position pos)
-        : id_(id), appeared_name_(name), position_(pos),
+    using allocator_type = std::pmr::polymorphic_allocator<std::byte>;
+    using Bag = std::pmr::vector<std::pair<int, int>>;
+
+    // Имя и рюкзак размещаются в памяти, на которую указывает alloc (обычно — память сессии)
+    Dog(int id, std::string_view name, model::Position pos, allocator_type alloc = {})
+        : id_(id), appeared_name_(name, alloc), position_(pos),
           speed_({0.0, 0.0}), direction_(Direction::NORTH),
-          bag_capacity_(0) {}
+          bag_capacity_(0), inventory_(alloc) {}
 
     int GetId() const { return id_; }
-    const std::string &GetName() const { return appeared_name_; }
+    std::string_view GetName() const { return appeared_name_; }
     const model::Position &GetPosition() const { return position_; }
     const model::Position &GetSpeed() const { return speed_; }
     Direction GetDirection() const { return direction_; }
@@ -94,7 +92,12 @@ public:
         }
     }
 
-    void SetBagCapacityForDog(int size) { bag_capacity_ = size; }
+    // Место под рюкзак выделяется один раз: больше вместимости он не вырастет
+    void SetBagCapacityForDog(int size)
+    {
+        bag_capacity_ = size;
+        inventory_.reserve(static_cast<size_t>(std::max(size, 0)));
+    }
     bool CanPickUp() const { return inventory_.size() < bag_capacity_; }
 
     void PickUpItem(int id, int type, int value)
@@ -105,7 +108,7 @@ public:
             RaiseScore(value);
         }
     }
-    const std::vector<std::pair<int, int>> GetBag() const
+    const Bag &GetBag() const
     {
         return inventory_;
     }
@@ -117,6 +120,12 @@ public:
     {
         return bag_capacity_;
     }
+    // Перемещение за ms миллисекунд. Отрезок перемещения запоминается для Gather.
+    // Если собака упёрлась в край дороги, возвращает, сколько секунд она успела пройти
+    std::optional<double> Move(int ms, GameSession *session);
+    // Подбор предметов и сдача их в офис на отрезке последнего перемещения.
+    // Учитывает только эту собаку; GameSession::GatherLoot упорядочивает события всех собак
+    void Gather(GameSession *session);
     void UpdatePosition(int ms, GameSession *session);
     const int GetScore() const
     {
@@ -164,17 +173,36 @@ public:
     }
     bool WasRecorded() const { return recorded_; }
     void MarkRecorded() { recorded_ = true; }
+    bool IsMoving() const { return speed_.x != 0.0 || speed_.y != 0.0; }
 
 private:
+    // Учёт сессии: место в списке движущихся собак и срок ухода остановившейся собаки.
+    // Остановившаяся собака либо стоит (скорость нулевая), либо упёрлась в край дороги
+    friend class GameSession;
+    static constexpr size_t NOT_MOVING = static_cast<size_t>(-1);
+    static constexpr uint64_t NO_DEADLINE = static_cast<uint64_t>(-1);
+    size_t moving_index_ = NOT_MOVING;
+    bool blocked_ = false;
+    double stopped_at_ms_ = 0.0;
+    // Точность сравнения пройденного пути с заданным
+    static constexpr double MOVE_EPSILON = 1e-9;
+    // Подбор предмета или сдача рюкзака в офисе: item_id — номер в списке PrepareGather
+    void CollectItem(GameSession *session, size_t item_id);
+    uint64_t retire_deadline_ms_ = NO_DEADLINE;
+
     int id_;
-    std::string appeared_name_;
+    std::pmr::string appeared_name_;
     model::Position position_;
+    model::Position move_start_{};
+    // Сколько секунд длилось последнее перемещение: от начала тика до остановки или конца тика
+    double move_time_ = 0.0;
+    bool gather_pending_ = false;
     model::Position speed_;
     Direction direction_;
     int bag_capacity_;
-    std::vector<std::pair<int, int>> inventory_;
+    Bag inventory_;
     int score_ = 0;
-    double retirement_timeout_;
+    double retirement_timeout_ = 60.0;
     double current_idle_time_ = 0.0;
     double life_time_ = 0.0;
     bool retired_ = false;
@@ -192,20 +220,74 @@ private:
     class SessionGathererProvider;
 
 public:
-    explicit GameSession(model::Map *map) : map_(map) {}
+    explicit GameSession(model::Map *map) : map_(map)
+    {
+        InitLootGenerator();
+        InitOfficeItems();
+    }
 
     model::Map *GetMap() const { return map_; }
+    // Фиксированное зерно делает появление собак и трофеев воспроизводимым
+    void SeedRandom(uint64_t seed) { random_ = util::FastRandom{seed}; }
 
-    std::shared_ptr<Dog> AddDog(const std::string &name, bool randomize_spawn = false)
+    std::shared_ptr<Dog> AddDog(std::string_view name, bool randomize_spawn = false)
     {
         model::Position pos = randomize_spawn
-                                  ? GetRandomPositionOnRoad(*map_)
+                                  ? GetRandomPositionOnRoad(*map_, random_)
                                   : model::Position{static_cast<double>(map_->GetRoads().front().GetStart().x),
                                                     static_cast<double>(map_->GetRoads().front().GetStart().y)};
-        auto dog = std::make_shared<Dog>(next_dog_id_++, name, pos);
-        dogs_.emplace_back(dog);
+        auto dog = CreateDog(next_dog_id_++, name, pos);
+        dog->SetBagCapacityForDog(map_->GetBagCapacityForMap());
+        dog->SetRetirementTimeout(map_->GetRetirementTime());
+        AttachDog(dog);
         return dog;
     }
+    // Добавляет в сессию собаку, созданную CreateDog. Параметры собаки
+    // к этому моменту должны быть заданы: от них зависит срок её ухода
+    void AttachDog(std::shared_ptr<Dog> dog)
+    {
+        if (dog->IsMoving())
+        {
+            AddMovingDog(dog);
+        }
+        else
+        {
+            ScheduleRetirement(dog, static_cast<double>(GetTimeMs()));
+        }
+        dogs_.emplace_back(std::move(dog));
+    }
+    // Смена направления и скорости собаки по команде игрока
+    void SteerDog(const std::shared_ptr<Dog> &dog, Direction dir, double speed)
+    {
+        const bool was_moving = dog->moving_index_ != Dog::NOT_MOVING;
+        dog->SetDirection(dir);
+        dog->SetSpeed(speed);
+        if (was_moving)
+        {
+            if (!dog->IsMoving())
+            {
+                RemoveMovingDog(*dog);
+                ScheduleRetirement(dog, static_cast<double>(GetTimeMs()));
+            }
+            return;
+        }
+        ResumeDog(dog);
+        if (dog->IsMoving())
+        {
+            AddMovingDog(dog);
+        }
+        else
+        {
+            ScheduleRetirement(dog, static_cast<double>(GetTimeMs()));
+        }
+    }
+    // Собака вместе со счётчиком ссылок размещается в памяти сессии, туда же
+    // аллокатор передаётся для имени и рюкзака. В список собак сессии не добавляется.
+    // Ни shared_ptr, ни weak_ptr на собаку не должны переживать сессию
+    std::shared_ptr<Dog> CreateDog(int id, std::string_view name, model::Position pos)
+    {
+        return std::allocate_shared<Dog>(std::pmr::polymorphic_allocator<Dog>{&pool_}, id, name, pos);
+    }
 
     struct LostObject
     {
@@ -214,22 +296,79 @@ public:
         int value = 0;
         model::Position pos;
     };
+    // Предметы лежат подряд в памяти сессии; дескриптор предмета остаётся
+    // действительным, пока сам предмет не подобран
+    using LostObjects = util::SlotMap<LostObject>;
     GameSession(model::Map *map,
                 std::vector<std::shared_ptr<Dog>> dogs,
                 int next_dog_id,
                 int next_loot_id,
-                std::unordered_map<int, LostObject> lost_objects)
-        : map_(map), dogs_(std::move(dogs)), next_dog_id_(next_dog_id), next_loot_id_(next_loot_id), lost_objects_(std::move(lost_objects)) {}
-    void AddRandomLoot(int count, const std::list<model::Road> &roads, int loot_type_count, const boost::json::array &loot_types)
+                const std::unordered_map<int, LostObject> &lost_objects)
+        : map_(map), dogs_(std::move(dogs)), next_dog_id_(next_dog_id), next_loot_id_(next_loot_id),
+          lost_objects_(&pool_)
+    {
+        lost_objects_.Reserve(lost_objects.size());
+        for (const auto &[id, obj] : lost_objects)
+        {
+            lost_objects_.Insert(obj);
+        }
+        InitLootGenerator();
+        InitOfficeItems();
+    }
+    void RemoveDog(int dog_id)
+    {
+        std::erase_if(dogs_, [this, dog_id](const std::shared_ptr<Dog> &dog)
+                      {
+                          if (dog->GetId() != dog_id)
+                          {
+                              return false;
+                          }
+                          RemoveMovingDog(*dog);
+                          return true;
+                      });
+    }
+    // Собаки, ушедшие на покой за текущий тик. Список очищает тот, кто их обработал
+    const std::vector<std::shared_ptr<Dog>> &GetRetiredDogs() const { return retired_dogs_; }
+    void ClearRetiredDogs() { retired_dogs_.clear(); }
+    // Время сессии: сумма длительностей всех тиков
+    uint64_t GetTimeMs() const { return retirement_wheel_.GetTime(); }
+    // Снимок состояния читается из любого потока, публикуется и сбрасывается в strand
+    std::shared_ptr<const SessionStateSnapshot> GetStateSnapshot() const
+    {
+        return state_snapshot_.load(std::memory_order_acquire);
+    }
+    void PublishStateSnapshot(std::shared_ptr<const SessionStateSnapshot> snapshot)
+    {
+        state_snapshot_.store(std::move(snapshot), std::memory_order_release);
+    }
+    // Вызывается тиком, командами движения и при смене состава игроков. Новый снимок собирается
+    // в strand при первом чтении, так что сессии без опрашивающих ничего не стоят
+    void InvalidateStateSnapshot()
+    {
+        state_snapshot_.store(nullptr, std::memory_order_release);
+    }
+    // Появление трофеев за прошедшее время. Генератор у каждого экземпляра
+    // сессии свой: у экземпляров одной карты разное число игроков и трофеев
+    void SpawnLoot(std::chrono::milliseconds delta)
     {
+        if (!loot_generator_)
+        {
+            return;
+        }
+        const unsigned count = loot_generator_->Generate(delta, static_cast<unsigned>(lost_objects_.size()), static_cast<unsigned>(dogs_.size()));
+        AddRandomLoot(static_cast<int>(count));
+    }
+    void AddRandomLoot(int count)
+    {
+        const auto &loot_types = map_->GetLootTypes();
         for (int i = 0; i < count; ++i)
         {
             LostObject obj;
             obj.id = next_loot_id_++;
-            obj.type = rand() % loot_type_count;
-            obj.pos = GetRandomPositionOnRoad(*map_);
-            obj.value = loot_types[obj.type].as_object().at("value").as_int64();
-            lost_objects_[obj.id] = obj;
+            obj.type = map_->PickLootType(random_.NextDouble());
+            obj.pos = GetRandomPositionOnRoad(*map_, random_);
+            obj.value = loot_types[obj.type].value;
+            lost_objects_.Insert(obj);
         }
     }
     int GetNextDogId() const
@@ -240,173 +379,479 @@ public:
     {
         return next_loot_id_;
     }
-    const std::unordered_map<int, LostObject> &GetLostObjects() const { return lost_objects_; }
-    std::unordered_map<int, LostObject> &AccessLostObjects() { return lost_objects_; }
+    const LostObjects &GetLostObjects() const { return lost_objects_; }
+    LostObjects &AccessLostObjects() { return lost_objects_; }
 
     const std::vector<std::shared_ptr<Dog>> &GetDogs() const { return dogs_; }
-    std::vector<std::shared_ptr<Dog>> &AccessDogs() { return dogs_; }
 
-    SessionGathererProvider GetGathererProvider(const std::vector<model::Position> &starts,
-                                                const std::vector<model::Position> &ends) const
+    // Шаги тика для всех собак сессии. Временные данные тика лежат в буферах сессии,
+    // которые между тиками очищаются, но не освобождаются.
+    // Стоящие собаки в тике не участвуют: их уход назначен в колесе таймеров
+    void MoveDogs(int ms);
+    void GatherLoot();
+
+    // Собака подбирает предметы в пределах DOG_GATHER_RADIUS от своего пути,
+    // а сдаёт рюкзак, проходя в пределах OFFICE_DROP_RADIUS от офиса
+    static constexpr double DOG_GATHER_RADIUS = 0.6;
+    static constexpr double OFFICE_DROP_RADIUS = 0.55;
+
+    // Предмет или офис, с которым собака может встретиться в текущем тике
+    struct GatherItem
     {
-        return SessionGathererProvider(*this, starts, ends);
+        LostObjects::Handle handle;
+        model::Position pos;
+        bool taken = false;
+        bool office = false;
+    };
+    // Запоминает лежащие на карте предметы перед подбором их собаками.
+    // Офисы стоят в начале списка и не меняются
+    void PrepareGather()
+    {
+        gather_items_.erase(gather_items_.begin() + office_count_, gather_items_.end());
+        for (size_t i = 0; i < lost_objects_.size(); ++i)
+        {
+            gather_items_.push_back({lost_objects_.GetHandle(i), (lost_objects_.begin() + i)->pos});
+        }
+        // Событий на одном отрезке не больше, чем предметов: буфер не растёт внутри тика
+        gather_events_.reserve(gather_items_.capacity());
+        BuildGatherGrid();
+    }
+    GatherItem &AccessGatherItem(size_t idx) { return gather_items_[idx]; }
+    // События подбора на отрезке from-to по времени. Ссылка действительна до следующего вызова
+    const std::vector<collision_detector::GatheringEvent> &FindGatherEvents(model::Position from,
+                                                                            model::Position to)
+    {
+        SelectGatherCandidates(from, to);
+        collision_detector::FindGatherEvents(SessionGathererProvider(*this, from, to), gather_events_);
+        for (auto &evt : gather_events_)
+        {
+            evt.item_id = gather_candidates_[evt.item_id];
+        }
+        return gather_events_;
     }
 
 private:
+    // Память сессии: собаки, их имена и рюкзаки, потерянные предметы. Пул переиспользует
+    // освобождённые блоки, а арена берёт у системы крупные куски и отдаёт их разом
+    // при уничтожении сессии. Объявлены первыми, чтобы разрушаться последними
+    std::pmr::monotonic_buffer_resource arena_;
+    std::pmr::unsynchronized_pool_resource pool_{&arena_};
     model::Map *map_;
     std::vector<std::shared_ptr<Dog>> dogs_;
     int next_dog_id_ = 0;
     int next_loot_id_ = 0;
-    std::unordered_map<int, LostObject> lost_objects_;
+    LostObjects lost_objects_{&pool_};
+    util::FastRandom random_;
+    std::optional<loot_gen::LootGenerator> loot_generator_;
+    std::atomic<std::shared_ptr<const SessionStateSnapshot>> state_snapshot_;
+    std::vector<GatherItem> gather_items_;
+    size_t office_count_ = 0;
+    std::vector<collision_detector::GatheringEvent> gather_events_;
+    // Грубая фаза подбора: номера предметов, разложенные по корзинам хеша клетки
+    // GATHER_CELL_SIZE x GATHER_CELL_SIZE, и предметы рядом с отрезком текущей собаки
+    std::vector<uint32_t> gather_bucket_starts_;
+    std::vector<uint32_t> gather_bucket_fill_;
+    std::vector<uint32_t> gather_bucket_items_;
+    size_t gather_bucket_mask_ = 0;
+    std::vector<uint32_t> gather_candidates_;
+    std::vector<std::shared_ptr<Dog>> moving_dogs_;
+    // Собаки, сдвинувшиеся в текущем тике; действительны до следующего MoveDogs
+    std::vector<Dog *> moved_dogs_;
+    // События подбора всех собак тика в порядке времени от начала тика
+    struct GatherQueueEntry
+    {
+        double time;
+        uint32_t dog;
+        uint32_t item;
+    };
+    std::vector<GatherQueueEntry> gather_queue_;
+    std::vector<std::shared_ptr<Dog>> retired_dogs_;
+    util::TimerWheel<std::weak_ptr<Dog>> retirement_wheel_{0, &pool_};
+
+    static double MillisToSeconds(double ms)
+    {
+        return ms / 1000.0;
+    }
+    void AddMovingDog(const std::shared_ptr<Dog> &dog)
+    {
+        dog->moving_index_ = moving_dogs_.size();
+        moving_dogs_.push_back(dog);
+    }
+    void RemoveMovingDog(Dog &dog)
+    {
+        if (dog.moving_index_ == Dog::NOT_MOVING)
+        {
+            return;
+        }
+        const size_t index = dog.moving_index_;
+        dog.moving_index_ = Dog::NOT_MOVING;
+        if (index + 1 != moving_dogs_.size())
+        {
+            moving_dogs_[index] = std::move(moving_dogs_.back());
+            moving_dogs_[index]->moving_index_ = index;
+        }
+        moving_dogs_.pop_back();
+    }
+    // Срок ухода остановившейся собаки не меняется, пока она не двигается,
+    // поэтому считается один раз от момента остановки stopped_at_ms
+    void ScheduleRetirement(const std::shared_ptr<Dog> &dog, double stopped_at_ms)
+    {
+        const double remaining = std::max(0.0, dog->GetRetirementTimeout() - dog->current_idle_time_);
+        dog->stopped_at_ms_ = stopped_at_ms;
+        dog->retire_deadline_ms_ = static_cast<uint64_t>(std::ceil(stopped_at_ms + remaining * 1000.0));
+        retirement_wheel_.Schedule(dog->retire_deadline_ms_, dog);
+    }
+    // Время простоя учитывается разом, когда остановившаяся собака получает новую команду.
+    // Упёршаяся собака, как и прежде, продолжает набирать время жизни, стоящая — нет
+    void ResumeDog(const std::shared_ptr<Dog> &dog)
+    {
+        const double stopped = MillisToSeconds(static_cast<double>(GetTimeMs()) - dog->stopped_at_ms_);
+        const bool was_retired = dog->IsRetired();
+        if (dog->blocked_)
+        {
+            dog->AddLifeTime(stopped);
+            dog->blocked_ = false;
+        }
+        dog->AddIdleTime(stopped);
+        dog->retire_deadline_ms_ = Dog::NO_DEADLINE;
+        QueueIfRetired(dog, was_retired);
+    }
+    void QueueIfRetired(const std::shared_ptr<Dog> &dog, bool was_retired)
+    {
+        if (!was_retired && dog->IsRetired())
+        {
+            retired_dogs_.push_back(dog);
+        }
+    }
+    void OnRetirementDeadline(const std::weak_ptr<Dog> &weak_dog, uint64_t deadline)
+    {
+        const auto dog = weak_dog.lock();
+        // Собака могла уйти из сессии, начать движение или остановиться заново
+        if (!dog || dog->moving_index_ != Dog::NOT_MOVING || dog->retire_deadline_ms_ != deadline || dog->IsRetired())
+        {
+            return;
+        }
+        // Срок округлён до миллисекунды вверх, а простой досчитывается ровно до порога
+        const double stopped = std::max(0.0, dog->GetRetirementTimeout() - dog->current_idle_time_);
+        if (dog->blocked_)
+        {
+            dog->AddLifeTime(stopped);
+        }
+        dog->current_idle_time_ += stopped;
+        dog->RetireDog();
+        retired_dogs_.push_back(dog);
+    }
+
+    static constexpr double GATHER_CELL_SIZE = 1.0;
+    static int64_t GatherCell(double coord)
+    {
+        return static_cast<int64_t>(std::floor(coord / GATHER_CELL_SIZE));
+    }
+    size_t GatherBucket(int64_t cell_x, int64_t cell_y) const
+    {
+        const uint64_t hash = static_cast<uint64_t>(cell_x) * 0x9E3779B97F4A7C15ull ^ static_cast<uint64_t>(cell_y) * 0xC2B2AE3D27D4EB4Full;
+        return static_cast<size_t>(hash ^ (hash >> 32)) & gather_bucket_mask_;
+    }
+    // Сортировка подсчётом. Корзин не меньше, чем предметов помещается в gather_items_:
+    // число корзин растёт вместе с этим буфером, а не при каждом новом предмете
+    void BuildGatherGrid()
+    {
+        const size_t bucket_count = std::bit_ceil(std::max<size_t>(gather_items_.capacity(), 1));
+        gather_bucket_mask_ = bucket_count - 1;
+        gather_bucket_starts_.assign(bucket_count + 1, 0);
+        for (const auto &item : gather_items_)
+        {
+            ++gather_bucket_starts_[GatherBucket(GatherCell(item.pos.x), GatherCell(item.pos.y)) + 1];
+        }
+        std::partial_sum(gather_bucket_starts_.begin(), gather_bucket_starts_.end(), gather_bucket_starts_.begin());
+        gather_bucket_fill_.assign(gather_bucket_starts_.begin(), gather_bucket_starts_.end() - 1);
+        gather_bucket_items_.resize(gather_items_.size());
+        // Кандидатов на одном отрезке не больше, чем предметов
+        gather_candidates_.reserve(gather_items_.capacity());
+        for (size_t i = 0; i < gather_items_.size(); ++i)
+        {
+            const auto &item = gather_items_[i];
+            gather_bucket_items_[gather_bucket_fill_[GatherBucket(GatherCell(item.pos.x), GatherCell(item.pos.y))]++] = static_cast<uint32_t>(i);
+        }
+    }
+    // Предметы из клеток, которые задевает отрезок from-to, расширенный на радиус подбора.
+    // В одну корзину попадают и чужие клетки, поэтому клетка предмета сверяется
+    void SelectGatherCandidates(model::Position from, model::Position to)
+    {
+        gather_candidates_.clear();
+        const int64_t min_x = GatherCell(std::min(from.x, to.x) - DOG_GATHER_RADIUS);
+        const int64_t max_x = GatherCell(std::max(from.x, to.x) + DOG_GATHER_RADIUS);
+        const int64_t min_y = GatherCell(std::min(from.y, to.y) - DOG_GATHER_RADIUS);
+        const int64_t max_y = GatherCell(std::max(from.y, to.y) + DOG_GATHER_RADIUS);
+        const uint64_t cell_count = static_cast<uint64_t>(max_x - min_x + 1) * static_cast<uint64_t>(max_y - min_y + 1);
+        // Длинный отрезок задевает больше клеток, чем есть корзин: проще проверить всё
+        if (cell_count > gather_bucket_mask_)
+        {
+            for (size_t i = 0; i < gather_items_.size(); ++i)
+            {
+                gather_candidates_.push_back(static_cast<uint32_t>(i));
+            }
+            return;
+        }
+        for (int64_t cell_y = min_y; cell_y <= max_y; ++cell_y)
+        {
+            for (int64_t cell_x = min_x; cell_x <= max_x; ++cell_x)
+            {
+                const size_t bucket = GatherBucket(cell_x, cell_y);
+                for (uint32_t k = gather_bucket_starts_[bucket]; k < gather_bucket_starts_[bucket + 1]; ++k)
+                {
+                    const uint32_t idx = gather_bucket_items_[k];
+                    const auto &pos = gather_items_[idx].pos;
+                    if (GatherCell(pos.x) == cell_x && GatherCell(pos.y) == cell_y)
+                    {
+                        gather_candidates_.push_back(idx);
+                    }
+                }
+            }
+        }
+        // По возрастанию, как при полном переборе: одновременные события идут в том же порядке
+        std::sort(gather_candidates_.begin(), gather_candidates_.end());
+    }
+
+    void InitOfficeItems()
+    {
+        for (const auto &office : map_->GetOffices())
+        {
+            GatherItem item;
+            item.pos = {static_cast<double>(office.GetPosition().x), static_cast<double>(office.GetPosition().y)};
+            item.office = true;
+            gather_items_.push_back(item);
+        }
+        office_count_ = gather_items_.size();
+    }
+    void InitLootGenerator()
+    {
+        if (map_->HasLootGenerator())
+        {
+            loot_generator_.emplace(map_->GetLootGenerator());
+        }
+    }
 
     class SessionGathererProvider : public collision_detector::ItemGathererProvider
     {
     public:
-        SessionGathererProvider(const GameSession &session,
-                                const std::vector<model::Position> &starts,
-                                const std::vector<model::Position> &ends)
-            : session_(session), starts_(starts), ends_(ends) {}
+        SessionGathererProvider(const GameSession &session, model::Position from, model::Position to)
+            : session_(session), from_(from), to_(to) {}
 
         size_t ItemsCount() const override
         {
-            return session_.lost_objects_.size();
+            return session_.gather_candidates_.size();
         }
 
         collision_detector::Item GetItem(size_t idx) const override
         {
-            auto it = session_.lost_objects_.begin();
-            std::advance(it, idx);
-            return {{it->second.pos.x, it->second.pos.y}, 0.0};
+            const auto &item = session_.gather_items_[session_.gather_candidates_[idx]];
+            return {{item.pos.x, item.pos.y}, item.office ? OFFICE_DROP_RADIUS - DOG_GATHER_RADIUS : 0.0};
         }
 
         size_t GatherersCount() const override
         {
-            return starts_.size();
+            return 1;
         }
 
-        collision_detector::Gatherer GetGatherer(size_t idx) const override
+        collision_detector::Gatherer GetGatherer(size_t) const override
         {
-            return {{starts_[idx].x, starts_[idx].y},
-                    {ends_[idx].x, ends_[idx].y},
-                    0.6};
+            return {{from_.x, from_.y}, {to_.x, to_.y}, DOG_GATHER_RADIUS};
         }
 
     private:
         const GameSession &session_;
-        const std::vector<model::Position> &starts_;
-        const std::vector<model::Position> &ends_;
+        model::Position from_;
+        model::Position to_;
     };
 };
 
-inline void Dog::UpdatePosition(int ms, GameSession *session)
+inline std::optional<double> Dog::Move(int ms, GameSession *session)
 {
     const double dt = std::chrono::duration<double>(std::chrono::milliseconds(ms)).count();
 
-    if (speed_.x == 0 && speed_.y == 0)
+    move_start_ = position_;
+    gather_pending_ = false;
+    const double speed_magnitude = std::sqrt(speed_.x * speed_.x + speed_.y * speed_.y);
+    if (speed_magnitude == 0.0)
     {
-        AddIdleTime(dt);
-        return;
+        return 0.0;
     }
 
-    model::Position start = position_;
-    model::Position attempted = {position_.x + speed_.x * dt, position_.y + speed_.y * dt};
-    model::Position new_pos = session->GetMap()->FitPositionToRoad(position_, attempted);
-
-    const double dx = new_pos.x - start.x;
-    const double dy = new_pos.y - start.y;
-    const double distance_moved = std::sqrt(dx * dx + dy * dy);
-    const double speed_magnitude = std::sqrt(speed_.x * speed_.x + speed_.y * speed_.y);
+    // Дорога может продолжаться соседней. Тогда от края дороги собака идёт дальше
+    // по следующей, поэтому длинный тик стоит столько проходов, сколько дорог пройдено,
+    // а не сколько коротких тиков в нём поместилось бы
+    const model::Map &map = *session->GetMap();
+    double remaining = dt;
+    while (remaining > 0.0)
+    {
+        const double wanted = speed_magnitude * remaining;
+        const model::Position attempted = {position_.x + speed_.x * remaining, position_.y + speed_.y * remaining};
+        const model::Position fitted = map.FitPositionToRoad(position_, attempted);
+        const double dx = fitted.x - position_.x;
+        const double dy = fitted.y - position_.y;
+        const double travelled = std::sqrt(dx * dx + dy * dy);
+        if (travelled <= MOVE_EPSILON)
+        {
+            // Упёрлась в край дороги, и дальше дороги нет
+            break;
+        }
+        position_ = fitted;
+        if (travelled >= wanted - MOVE_EPSILON)
+        {
+            remaining = 0.0;
+            break;
+        }
+        remaining -= travelled / speed_magnitude;
+    }
 
-    if (distance_moved > 0.0 && speed_magnitude > 0.0)
+    const double active_time = dt - remaining;
+    move_time_ = active_time;
+    if (!(position_ == move_start_))
     {
-        const double active_time = distance_moved / speed_magnitude;
-        const double idle_time = std::max(0.0, dt - active_time);
-        AddIdleTime(idle_time);
+        // Отрезок прямой: собака не меняет направления, пока ей не скомандуют
+        current_idle_time_ = 0.0;
+        gather_pending_ = true;
     }
-    else
+    AddLifeTime(active_time);
+    if (remaining > 0.0)
     {
-        AddIdleTime(dt);
+        return active_time;
     }
+    return std::nullopt;
+}
 
-    position_ = new_pos;
-
-    if (distance_moved == speed_magnitude * dt)
+inline void Dog::Gather(GameSession *session)
+{
+    if (!gather_pending_)
     {
-        current_idle_time_ = 0.0;
+        return;
     }
+    gather_pending_ = false;
 
-    std::vector<model::Position> starts = {start};
-    std::vector<model::Position> ends = {position_};
-    auto provider = session->GetGathererProvider(starts, ends);
-    auto events = collision_detector::FindGatherEvents(provider);
-
-    std::set<size_t> picked_items;
-    for (const auto &evt : events)
+    // Ожидается, что список предметов подготовлен PrepareGather; предметы,
+    // подобранные другими собаками в этом тике, помечены taken.
+    // Подбор и сдача рюкзака в офисе идут в порядке прохождения отрезка
+    for (const auto &evt : session->FindGatherEvents(move_start_, position_))
     {
-        if (evt.gatherer_id != 0)
-            continue;
-        auto it = session->AccessLostObjects().begin();
-        std::advance(it, evt.item_id);
-        if (CanPickUp())
-        {
-            PickUpItem(it->second.id, it->second.type, it->second.value);
-            picked_items.insert(it->second.id);
-        }
+        CollectItem(session, evt.item_id);
     }
+}
 
-    for (int id : picked_items)
+inline void Dog::CollectItem(GameSession *session, size_t item_id)
+{
+    auto &item = session->AccessGatherItem(item_id);
+    if (item.office)
+    {
+        ClearBag();
+        return;
+    }
+    if (item.taken || !CanPickUp())
     {
-        session->AccessLostObjects().erase(id);
+        return;
     }
+    auto &lost_objects = session->AccessLostObjects();
+    const auto *obj = lost_objects.Find(item.handle);
+    PickUpItem(obj->id, obj->type, obj->value);
+    lost_objects.Erase(item.handle);
+    item.taken = true;
+}
 
-    // проверка офиса
-    for (const auto &office : session->GetMap()->GetOffices())
+inline void Dog::UpdatePosition(int ms, GameSession *session)
+{
+    Move(ms, session);
+    session->PrepareGather();
+    Gather(session);
+}
+
+inline void GameSession::MoveDogs(int ms)
+{
+    const double tick_start_ms = static_cast<double>(GetTimeMs());
+    moved_dogs_.clear();
+    for (size_t i = 0; i < moving_dogs_.size();)
     {
-        const auto &pos = office.GetPosition();
-        double dx = static_cast<double>(pos.x) - position_.x;
-        double dy = static_cast<double>(pos.y) - position_.y;
-        if (dx * dx + dy * dy <= 0.55 * 0.55)
+        Dog &dog = *moving_dogs_[i];
+        const std::optional<double> active_time = dog.Move(ms, this);
+        if (dog.gather_pending_)
         {
-            ClearBag();
-            break;
+            moved_dogs_.push_back(&dog);
+        }
+        if (!active_time)
+        {
+            ++i;
+            continue;
+        }
+        // Упёршаяся собака больше не двигается, пока игрок её не развернёт.
+        // Её уход назначается от момента упора, даже если он пришёлся на середину тика
+        const std::shared_ptr<Dog> blocked = moving_dogs_[i];
+        RemoveMovingDog(dog);
+        blocked->blocked_ = true;
+        ScheduleRetirement(blocked, tick_start_ms + *active_time * 1000.0);
+    }
+    retirement_wheel_.Advance(GetTimeMs() + static_cast<uint64_t>(ms),
+                              [this](const std::weak_ptr<Dog> &dog, uint64_t deadline)
+                              { OnRetirementDeadline(dog, deadline); });
+}
+
+// Все собаки начинают тик одновременно, поэтому событие на отрезке собаки случается
+// через долю отрезка, умноженную на время её движения. События всех собак разбираются
+// в общем порядке времени: предмет достаётся той, что дошла до него раньше,
+// а не той, что раньше в списке, как бы ни был длинен тик
+inline void GameSession::GatherLoot()
+{
+    PrepareGather();
+    gather_queue_.clear();
+    // Обычно за тик событий не больше, чем собак и предметов вместе. Ёмкости этих буферов
+    // меняются только при их собственном росте, так что очередь растёт вместе с ними,
+    // а не при каждом новом рекорде событий. Больше событий дают лишь длинные тики
+    gather_queue_.reserve(moved_dogs_.capacity() + gather_items_.capacity());
+    for (size_t i = 0; i < moved_dogs_.size(); ++i)
+    {
+        Dog &dog = *moved_dogs_[i];
+        if (!dog.gather_pending_)
+        {
+            continue;
+        }
+        dog.gather_pending_ = false;
+        for (const auto &evt : FindGatherEvents(dog.move_start_, dog.position_))
+        {
+            gather_queue_.push_back({evt.time * dog.move_time_, static_cast<uint32_t>(i), static_cast<uint32_t>(evt.item_id)});
         }
     }
-    AddLifeTime(dt);
+    std::sort(gather_queue_.begin(), gather_queue_.end(), [](const GatherQueueEntry &lhs, const GatherQueueEntry &rhs)
+              {
+                  if (lhs.time != rhs.time)
+                  {
+                      return lhs.time < rhs.time;
+                  }
+                  return lhs.dog != rhs.dog ? lhs.dog < rhs.dog : lhs.item < rhs.item; });
+    for (const auto &entry : gather_queue_)
+    {
+        moved_dogs_[entry.dog]->CollectItem(this, entry.item);
+    }
 }
 
+// Игрок держит и собаку, и её сессию. Собака размещена в памяти сессии,
+// поэтому dog_ объявлена после session_ и освобождается раньше неё
 class Player
 {
 public:
     Player(std::shared_ptr<GameSession> session, std::shared_ptr<Dog> dog)
-        : session_(std::move(session)), dog_(std::move(dog)),
-          generator1_(std::random_device{}()), generator2_(std::random_device{}())
+        : session_(std::move(session)), dog_(std::move(dog)), token_(Token::Generate())
     {
-        token_ = GenerateToken();
     }
     explicit Player(std::shared_ptr<GameSession> session,
                     std::shared_ptr<Dog> dog,
                     Token token)
-        : session_(std::move(session)), dog_(std::move(dog)), token_(std::move(token)), generator1_(std::random_device{}()), generator2_(std::random_device{}()) {}
+        : session_(std::move(session)), dog_(std::move(dog)), token_(token) {}
     std::shared_ptr<GameSession> GetSession() const { return session_; }
-    std::optional<Token> GetToken() const { return token_; }
+    const Token &GetToken() const { return token_; }
     std::shared_ptr<Dog> GetDog() const { return dog_; }
 
 private:
     std::shared_ptr<GameSession> session_;
     std::shared_ptr<Dog> dog_;
-    std::optional<Token> token_;
-    std::mt19937_64 generator1_;
-    std::mt19937_64 generator2_;
-
-    Token GenerateToken()
-    {
-        uint64_t part1 = generator1_();
-        uint64_t part2 = generator2_();
-        std::ostringstream oss;
-        oss << std::hex << std::setw(16) << std::setfill('0') << part1
-            << std::setw(16) << std::setfill('0') << part2;
-        return Token{oss.str()};
-    }
+    Token token_;
 };
 
 class Players
@@ -414,11 +859,12 @@ class Players
 public:
     Player &AddPlayer(std::shared_ptr<GameSession> session, std::shared_ptr<Dog> dog)
     {
-        players_.emplace_back(std::make_unique<Player>(std::move(session), std::move(dog)));
-        return *players_.back();
+        return AddPlayer(std::make_unique<Player>(std::move(session), std::move(dog)));
     }
     Player &AddPlayer(std::unique_ptr<Player> player)
     {
+        by_token_[player->GetToken()] = player.get();
+        by_dog_[player->GetDog().get()] = player.get();
         players_.emplace_back(std::move(player));
         return *players_.back();
     }
@@ -435,17 +881,16 @@ public:
         return nullptr;
     }
 
-    Player *FindByToken(Token token) const
+    Player *FindByDog(const Dog *dog) const
     {
-        for (const auto &player : players_)
-        {
-            const auto player_token = player->GetToken();
-            if (player_token.has_value() && player_token.value() == token)
-            {
-                return player.get();
-            }
-        }
-        return nullptr;
+        auto it = by_dog_.find(dog);
+        return it != by_dog_.end() ? it->second : nullptr;
+    }
+
+    Player *FindByToken(const Token &token) const
+    {
+        auto it = by_token_.find(token);
+        return it != by_token_.end() ? it->second : nullptr;
     }
 
     int GetPlayerCount() const
@@ -457,17 +902,46 @@ public:
     {
         return players_;
     }
+    // Удаляет из игры игроков, чьи собаки ушли на покой в session, и очищает её список ушедших.
+    // on_retired(dog) вызывается для каждой такой собаки ровно один раз, до удаления игрока.
+    // Игроки с активными собаками не затрагиваются. Возвращает число удалённых игроков
+    template <typename OnRetired>
+    size_t RemoveRetired(GameSession &session, OnRetired &&on_retired)
+    {
+        size_t removed = 0;
+        for (const auto &dog : session.GetRetiredDogs())
+        {
+            Player *player = FindByDog(dog.get());
+            if (!player || dog->WasRecorded())
+            {
+                continue;
+            }
+            dog->MarkRecorded();
+            on_retired(*dog);
+            const Token token = player->GetToken();
+            session.RemoveDog(dog->GetId());
+            RemoveByToken(token);
+            ++removed;
+        }
+        session.ClearRetiredDogs();
+        return removed;
+    }
     void RemoveByToken(const Token &token)
     {
-        players_.erase(
-            std::remove_if(players_.begin(), players_.end(),
-                           [&](const std::unique_ptr<Player> &p)
-                           {
-                               return p->GetToken().has_value() && p->GetToken().value() == token;
-                           }),
-            players_.end());
+        auto it = by_token_.find(token);
+        if (it == by_token_.end())
+        {
+            return;
+        }
+        const Player *player = it->second;
+        by_token_.erase(it);
+        by_dog_.erase(player->GetDog().get());
+        std::erase_if(players_, [player](const std::unique_ptr<Player> &p)
+                      { return p.get() == player; });
     }
 
 private:
     std::vector<std::unique_ptr<Player>> players_;
+    std::unordered_map<Token, Player *, TokenHasher> by_token_;
+    std::unordered_map<const Dog *, Player *> by_dog_;
 };
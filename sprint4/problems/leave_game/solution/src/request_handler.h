@@ -2,15 +2,25 @@
 
 #include "model.h"
 #include "objects.h"
+#include "bots.h"
 #include "extra_data.h"
 #include "state_serialization.h"
 #include "record_repository.h"
+#include "async_log_sink.h"
+#include "api_router.h"
+#include "metrics.h"
+#include "shared_string_body.h"
+#include "file_io.h"
 #include <boost/beast/http.hpp>
+#include <boost/asio/bind_executor.hpp>
 #include <boost/asio/io_context.hpp>
 #include <boost/asio/strand.hpp>
+#include <boost/asio/thread_pool.hpp>
 #include <boost/json.hpp>
 #include <boost/log/trivial.hpp>
 #include <boost/log/utility/setup/console.hpp>
+#include <boost/log/sinks/unlocked_frontend.hpp>
+#include <boost/log/expressions.hpp>
 #include <boost/log/utility/setup/common_attributes.hpp>
 #include <boost/log/utility/manipulators/add_value.hpp>
 #include <boost/log/attributes.hpp>
@@ -19,6 +29,9 @@
 #include <boost/asio/steady_timer.hpp>
 #include <boost/archive/binary_oarchive.hpp>
 #include <boost/archive/binary_iarchive.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
 
 #include <iomanip>
 #include <filesystem>
@@ -29,6 +42,8 @@
 #include <unordered_map>
 #include <chrono>
 #include <algorithm>
+#include <atomic>
+#include <thread>
 
 namespace net = boost::asio;
 namespace sys = boost::system;
@@ -43,15 +58,45 @@ namespace http_handler
 
     BOOST_LOG_ATTRIBUTE_KEYWORD(additional_data, "AdditionalData", json::value)
 
-    inline void InitLogging()
+    // Память под разбор тела и сборку ответа одного запроса. Создаётся на стеке обработчика:
+    // документы API небольшие и помещаются в буфер целиком, а больший документ
+    // дозапрашивает память у кучи крупными кусками. Всё освобождается разом с ареной
+    class RequestArena
+    {
+    public:
+        RequestArena() = default;
+        RequestArena(const RequestArena &) = delete;
+        RequestArena &operator=(const RequestArena &) = delete;
+
+        json::storage_ptr Storage() noexcept
+        {
+            return &resource_;
+        }
+
+    private:
+        static constexpr size_t BUFFER_SIZE = 4096;
+        alignas(std::max_align_t) unsigned char buffer_[BUFFER_SIZE];
+        json::monotonic_resource resource_{buffer_, BUFFER_SIZE};
+    };
+
+    inline boost::shared_ptr<logging::sinks::unlocked_sink<async_log::AsyncLineBackend>> &LogSink()
+    {
+        static boost::shared_ptr<logging::sinks::unlocked_sink<async_log::AsyncLineBackend>> sink;
+        return sink;
+    }
+
+    inline void InitLogging(const async_log::SinkSettings &settings = {})
     {
         static bool initialized = false;
         if (initialized)
             return;
         initialized = true;
         logging::add_common_attributes();
-        logging::add_console_log(std::cout, boost::log::keywords::auto_flush = true, logging::keywords::format = [](const logging::record_view &rec, logging::formatting_ostream &strm)
-                                                                                     {
+        auto backend = boost::make_shared<async_log::AsyncLineBackend>(stdout, settings.queue_capacity, settings.batch_size);
+        auto sink = boost::make_shared<logging::sinks::unlocked_sink<async_log::AsyncLineBackend>>(backend);
+        sink->set_filter(logging::trivial::severity >= settings.min_level);
+        sink->set_formatter([](const logging::record_view &rec, logging::formatting_ostream &strm)
+                            {
         using boost::posix_time::to_iso_extended_string;
         json::object obj;
         if (auto ts = logging::extract<boost::posix_time::ptime>("TimeStamp", rec)) {
@@ -67,7 +112,107 @@ namespace http_handler
         }
         
         strm << json::serialize(obj); });
+        logging::core::get()->add_sink(sink);
+        LogSink() = sink;
     }
+
+    // Дописывает накопившиеся в очереди записи и останавливает поток записи
+    inline void ShutdownLogging()
+    {
+        if (auto &sink = LogSink())
+        {
+            logging::core::get()->remove_sink(sink);
+            sink->flush();
+            sink->locked_backend()->Stop();
+            sink.reset();
+        }
+    }
+    // Область, объекты которой попадают в ответ /game/state
+    struct ViewFilter
+    {
+        enum class Kind
+        {
+            ALL,
+            RADIUS,
+            RECT
+        };
+        Kind kind = Kind::ALL;
+        model::Position center{};
+        double radius = 0.0;
+        model::Position min{};
+        model::Position max{};
+
+        bool Contains(const model::Position &pos) const noexcept
+        {
+            switch (kind)
+            {
+            case Kind::RADIUS:
+            {
+                const double dx = pos.x - center.x;
+                const double dy = pos.y - center.y;
+                return dx * dx + dy * dy <= radius * radius;
+            }
+            case Kind::RECT:
+                return pos.x >= min.x && pos.x <= max.x && pos.y >= min.y && pos.y <= max.y;
+            case Kind::ALL:
+                break;
+            }
+            return true;
+        }
+    };
+
+    // Разбирает параметры radius=R (вокруг собаки игрока) или x0, y0, x1, y1
+    // (прямоугольник). Без параметров видна вся сессия.
+    // Возвращает nullopt, если параметры заданы неверно
+    inline std::optional<ViewFilter> ParseViewFilter(std::string_view query, const model::Position &center)
+    {
+        using namespace std::literals;
+        ViewFilter filter;
+        if (const auto radius = api_router::FindQueryParam(query, "radius"sv))
+        {
+            if (!api_router::ParseDouble(*radius, filter.radius) || filter.radius < 0.0)
+            {
+                return std::nullopt;
+            }
+            filter.kind = ViewFilter::Kind::RADIUS;
+            filter.center = center;
+            return filter;
+        }
+
+        const auto x0 = api_router::FindQueryParam(query, "x0"sv);
+        const auto y0 = api_router::FindQueryParam(query, "y0"sv);
+        const auto x1 = api_router::FindQueryParam(query, "x1"sv);
+        const auto y1 = api_router::FindQueryParam(query, "y1"sv);
+        if (!x0 && !y0 && !x1 && !y1)
+        {
+            return filter;
+        }
+        model::Position a, b;
+        if (!x0 || !y0 || !x1 || !y1 ||
+            !api_router::ParseDouble(*x0, a.x) || !api_router::ParseDouble(*y0, a.y) ||
+            !api_router::ParseDouble(*x1, b.x) || !api_router::ParseDouble(*y1, b.y))
+        {
+            return std::nullopt;
+        }
+        filter.kind = ViewFilter::Kind::RECT;
+        filter.min = {std::min(a.x, b.x), std::min(a.y, b.y)};
+        filter.max = {std::max(a.x, b.x), std::max(a.y, b.y)};
+        return filter;
+    }
+
+    inline std::string GzipCompress(std::string_view data)
+    {
+        namespace io = boost::iostreams;
+        std::string result;
+        {
+            io::filtering_ostream out;
+            out.push(io::gzip_compressor(io::gzip_params(io::gzip::best_speed)));
+            out.push(io::back_inserter(result));
+            out.write(data.data(), static_cast<std::streamsize>(data.size()));
+        }
+        return result;
+    }
+
     class RequestHandler;
     class ApiRequestHandler
     {
@@ -79,135 +224,187 @@ namespace http_handler
                           bool randomize_spawn,
                           std::optional<std::filesystem::path> state_file_path,
                           std::optional<std::chrono::milliseconds> save_period,
-                          std::shared_ptr<database::RecordRepository> record_repo)
+                          std::shared_ptr<database::RecordRepository> record_repo,
+                          size_t max_players_per_session = 0,
+                          bots::Settings bot_settings = {},
+                          bool async_file_io = false)
             : game_(game),
               strand_(strand),
               randomize_spawn_(randomize_spawn),
               state_file_path_(std::move(state_file_path)),
               save_period_(save_period),
-              record_repo_(std::move(record_repo))
+              record_repo_(std::move(record_repo)),
+              sessions_by_map_(game.GetMapCount()),
+              max_players_per_session_(max_players_per_session),
+              async_file_io_(async_file_io)
         {
             LoadState();
+            if (bot_settings.bots_per_map > 0)
+            {
+                bots_.emplace(bot_settings, game_.GetMapCount(), [this](size_t map_index, std::string_view name)
+                              {
+                                  Player &player = JoinPlayer(&game_.GetMapByIndex(map_index), name);
+                                  return bots::Joined{player.GetSession(), player.GetDog()}; });
+            }
+            PublishWorldSnapshot();
         }
 
+        // match — результат api_router::Match(req.target()). Его string_view указывают
+        // в буфер полей запроса, который переезжает вместе с запросом при перемещении
         template <typename Body, typename Allocator, typename Send>
-        void HandleRequest(const http::request<Body, http::basic_fields<Allocator>> &req, Send &&send)
+        void HandleRequest(http::request<Body, http::basic_fields<Allocator>> &&req, Send &&send, const api_router::RouteMatch &match)
         {
-            using namespace std::literals;
-            const std::string target = std::string(req.target());
-
-            if (target == "/api/v1/maps")
+            if (!match)
             {
-                if (req.method() != http::verb::get && req.method() != http::verb::head)
-                {
-                    // send(MakeError(http::status::method_not_allowed, "invalidMethod", "Only GET, HEAD method supported", req));
-                    http::response<http::string_body> res = MakeError(http::status::method_not_allowed, "invalidMethod", "Only GET, HEAD method supported", req);
-                    res.set(http::field::allow, "GET, HEAD");
-                    send(res);
-                }
-                else
-                {
-                    send(HandleMapsList(req));
-                }
+                send(MakeError(http::status::bad_request, "badRequest", "Bad request", req));
                 return;
             }
+            const api_router::Route &route = *match.route;
 
-            if (target.starts_with("/api/v1/maps/"))
+            if (route.endpoint == api_router::Endpoint::TICK && AutoTick_)
             {
-                if (req.method() != http::verb::get && req.method() != http::verb::head)
-                {
-                    http::response<http::string_body> res = MakeError(http::status::method_not_allowed, "invalidMethod", "Only GET, HEAD method supported", req);
-                    res.set(http::field::allow, "GET, HEAD");
-                    send(res);
-                }
-                else
-                {
-                    send(HandleMapById(req));
-                }
+                send(MakeError(http::status::bad_request, "badRequest", "Invalid endpoint", req));
                 return;
             }
-
-            // Потенциально изменяет состояние — оборачиваем в strand
-            if (target.starts_with("/api/v1/game/join"))
+            if (!route.Allows(req.method()))
             {
-                boost::asio::dispatch(strand_, [this, req, send = std::forward<Send>(send)]() mutable
-                                      { send(HandleJoinPlayer(req)); });
+                http::response<http::string_body> res = MakeError(http::status::method_not_allowed, "invalidMethod", route.method_error, req);
+                res.set(http::field::allow, route.allow);
+                send(std::move(res));
                 return;
             }
 
-            if (target.starts_with("/api/v1/game/players"))
+            if (route.endpoint == api_router::Endpoint::STATE || route.endpoint == api_router::Endpoint::PLAYERS)
             {
-                boost::asio::post(strand_, [this, req, send = std::forward<Send>(send)]() mutable
-                                  { send(HandlePlayersList(req)); });
-                return;
+                // Чтение из опубликованного снимка идёт прямо в потоке ввода-вывода,
+                // не дожидаясь тиков и действий в strand
+                if (auto snapshot = FindCachedSnapshot(req, match.query))
+                {
+                    if (route.endpoint == api_router::Endpoint::STATE)
+                    {
+                        send(MakeStateResponse(std::move(snapshot), GetStateResponseOptions(req)));
+                    }
+                    else
+                    {
+                        send(MakePlayersResponse(std::move(snapshot), req));
+                    }
+                    return;
+                }
             }
-
-            if (target.starts_with("/api/v1/game/state"))
+            if (route.runner == api_router::Runner::IO)
             {
-                boost::asio::dispatch(strand_, [this, req, send = std::forward<Send>(send)]() mutable
-                                      { send(HandleGameState(req)); });
+                RunEndpoint(match, req, send);
                 return;
             }
-
-            if (target.starts_with("/api/v1/game/player/action"))
+            if (route.runner == api_router::Runner::BLOCKING)
             {
-                boost::asio::dispatch(strand_, [this, req, send = std::forward<Send>(send)]() mutable
-                                      { send(HandleGameActions(req)); });
+                // Запрос к базе блокирует поток, поэтому не занимает ни strand, ни поток
+                // сессии. send сам переносит запись ответа в исполнитель сессии
+                net::post(blocking_pool_, [this, match, req = std::move(req), send = std::forward<Send>(send)]() mutable
+                          {
+                    try
+                    {
+                        RunEndpoint(match, req, send);
+                    }
+                    catch (const std::exception &ex)
+                    {
+                        BOOST_LOG_TRIVIAL(error) << "Blocking request failed: " << ex.what();
+                        send(MakeError(http::status::internal_server_error, "internalError", "Internal server error", req));
+                    } });
                 return;
             }
-            if (target.starts_with("/api/v1/game/tick"))
+            // Потенциально изменяет состояние — выполняем в strand
+            boost::asio::dispatch(strand_, [this, match, queued = std::chrono::steady_clock::now(), req = std::move(req), send = std::forward<Send>(send)]() mutable
+                                  {
+                metrics::Observe(metrics::Timer::STRAND_WAIT, std::chrono::steady_clock::now() - queued);
+                RunEndpoint(match, req, send); });
+        }
+        // Синхронное сохранение: при остановке сервера io_context уже не работает
+        void SaveState()
+        {
+            if (!state_file_path_)
+                return;
+
+            metrics::ScopedTimer timer{metrics::Timer::SNAPSHOT};
+            try
             {
-                if (AutoTick_)
+                const std::string snapshot = SerializeState();
+                std::ofstream ofs(state_file_path_->string() + ".tmp", std::ios::binary);
+                ofs.write(snapshot.data(), static_cast<std::streamsize>(snapshot.size()));
+                ofs.close();
+                if (!ofs)
                 {
-                    send(MakeError(http::status::bad_request, "badRequest", "Invalid endpoint", req));
-                    return;
+                    throw std::runtime_error("write failed");
                 }
-                boost::asio::dispatch(strand_, [this, req, send = std::forward<Send>(send)]() mutable
-                                      { send(HandleGameTick(req)); });
-                return;
+
+                std::filesystem::rename(state_file_path_->string() + ".tmp", *state_file_path_);
+                BOOST_LOG_TRIVIAL(info) << "Game state saved to: " << state_file_path_->string();
             }
-            if (req.target() == "/api/v1/game/records"sv)
+            catch (const std::exception &ex)
             {
-                boost::asio::dispatch(strand_, [this, req, send = std::forward<Send>(send)]() mutable
-                                      { send(HandleGameRecords(req)); });
-                return;
+                BOOST_LOG_TRIVIAL(error) << "Failed to save game state: " << ex.what();
             }
-            // Всё остальное — ошибка
-            send(MakeError(http::status::bad_request, "badRequest", "Bad request", req));
         }
-        void SaveState()
+        // Сохранение из тика: в strand только сериализация, запись идёт через file_io.
+        // Пока предыдущий снимок пишется, новый не начинается
+        void SaveStateAsync()
         {
-            if (!state_file_path_)
+            if (!state_file_path_ || snapshot_writing_)
                 return;
 
+            metrics::ScopedTimer timer{metrics::Timer::SNAPSHOT};
+            std::string snapshot;
             try
             {
-                std::vector<SessionRepr> session_reprs;
-                for (const auto &[id, session] : sessions_)
+                snapshot = SerializeState();
+            }
+            catch (const std::exception &ex)
+            {
+                BOOST_LOG_TRIVIAL(error) << "Failed to save game state: " << ex.what();
+                return;
+            }
+            // Свой временный файл: если сервер остановится посреди записи, SaveState не пересечётся с ней
+            const std::filesystem::path tmp_path = state_file_path_->string() + ".async.tmp";
+            snapshot_writing_ = true;
+            file_io::AsyncWriteFile(strand_, tmp_path, std::move(snapshot), [this, tmp_path](sys::error_code ec)
+                                    {
+                snapshot_writing_ = false;
+                std::error_code rename_ec;
+                if (!ec)
                 {
-                    session_reprs.emplace_back(*session);
+                    std::filesystem::rename(tmp_path, *state_file_path_, rename_ec);
                 }
-
-                std::vector<PlayerRepr> player_reprs;
-                for (const auto &player_ptr : players_.GetPlayers())
+                if (ec || rename_ec)
                 {
-                    player_reprs.emplace_back(*player_ptr);
+                    BOOST_LOG_TRIVIAL(error) << "Failed to save game state: " << (ec ? ec.message() : rename_ec.message());
+                    return;
                 }
+                BOOST_LOG_TRIVIAL(info) << "Game state saved to: " << state_file_path_->string(); });
+        }
+        std::string SerializeState() const
+        {
+            std::vector<SessionRepr> session_reprs;
+            std::unordered_map<const GameSession *, size_t> session_indices;
+            for (const auto &session : sessions_)
+            {
+                session_indices.emplace(session.get(), session_reprs.size());
+                session_reprs.emplace_back(*session);
+            }
 
-                SerializedState state{std::move(session_reprs), std::move(player_reprs)};
+            std::vector<PlayerRepr> player_reprs;
+            for (const auto &player_ptr : players_.GetPlayers())
+            {
+                player_reprs.emplace_back(*player_ptr, session_indices.at(player_ptr->GetSession().get()));
+            }
 
-                std::ofstream ofs(state_file_path_->string() + ".tmp", std::ios::binary);
-                boost::archive::binary_oarchive archive(ofs);
-                archive << state;
-                ofs.close();
+            SerializedState state{std::move(session_reprs), std::move(player_reprs)};
 
-                std::filesystem::rename(state_file_path_->string() + ".tmp", *state_file_path_);
-                BOOST_LOG_TRIVIAL(info) << "Game state saved to: " << state_file_path_->string();
-            }
-            catch (const std::exception &ex)
+            std::ostringstream out(std::ios::binary);
             {
-                BOOST_LOG_TRIVIAL(error) << "Failed to save game state: " << ex.what();
+                boost::archive::binary_oarchive archive(out);
+                archive << state;
             }
+            return std::move(out).str();
         }
         bool LoadState()
         {
@@ -230,28 +427,38 @@ namespace http_handler
                 SerializedState state;
                 archive >> state;
 
+                std::vector<std::shared_ptr<GameSession>> restored;
                 for (const auto &session_repr : state.sessions)
                 {
-                    const model::Map *map = game_.FindMap(session_repr.GetMapId());
+                    model::Map *map = game_.FindMap(session_repr.GetMapId());
                     if (!map)
                     {
                         BOOST_LOG_TRIVIAL(error) << "Map not found for session during restore";
                         return false;
                     }
-                    auto session = session_repr.Restore(const_cast<model::Map *>(map));
-                    sessions_[*map->GetId()] = session;
+                    restored.push_back(session_repr.Restore(map));
+                    AddSession(restored.back());
                 }
 
                 for (const auto &player_repr : state.players)
                 {
-                    auto it = sessions_.find(*player_repr.GetMapId());
-                    if (it == sessions_.end())
+                    std::shared_ptr<GameSession> session;
+                    if (const auto index = player_repr.GetSessionIndex())
+                    {
+                        session = *index < restored.size() ? restored[*index] : nullptr;
+                    }
+                    else if (const model::Map *map = game_.FindMap(player_repr.GetMapId());
+                             map && !sessions_by_map_[map->GetIndex()].empty())
+                    {
+                        session = sessions_by_map_[map->GetIndex()].front();
+                    }
+                    if (!session)
                     {
                         BOOST_LOG_TRIVIAL(error) << "Session not found for player during restore";
                         return false;
                     }
 
-                    std::unique_ptr<Player> player = player_repr.Restore(it->second);
+                    std::unique_ptr<Player> player = player_repr.Restore(session);
                     players_.AddPlayer(std::move(player));
                 }
 
@@ -268,14 +475,146 @@ namespace http_handler
     private:
         model::Game &game_;
         Players players_;
+        // Неизменяемый снимок для чтения из любого потока. Новый снимок подменяет
+        // старый атомарно, а старый освобождается, когда его отпустит последний читатель
+        struct WorldSnapshot
+        {
+            std::unordered_map<Token, std::shared_ptr<GameSession>, TokenHasher> sessions_by_token;
+        };
+        std::atomic<std::shared_ptr<const WorldSnapshot>> world_snapshot_;
+        bool players_changed_ = true;
         boost::asio::strand<boost::asio::io_context::executor_type> strand_;
-        std::unordered_map<std::string, std::shared_ptr<GameSession>> sessions_;
         bool AutoTick_ = false;
         bool randomize_spawn_ = false;
         std::optional<std::filesystem::path> state_file_path_;
         std::optional<std::chrono::milliseconds> save_period_;
         std::atomic<int> accumulated_time_ms_ = 0;
         std::shared_ptr<database::RecordRepository> record_repo_;
+        // Экземпляры сессий по индексу карты (Map::GetIndex)
+        std::vector<std::vector<std::shared_ptr<GameSession>>> sessions_by_map_;
+        // Все существующие сессии в порядке создания — по ним проходит тик
+        std::vector<std::shared_ptr<GameSession>> sessions_;
+        // Наибольшее число игроков в одном экземпляре сессии, 0 — без ограничения
+        size_t max_players_per_session_ = 0;
+        // Боты внутри процесса, если заданы в настройках
+        std::optional<bots::BotPopulation> bots_;
+        // Снимки из тика пишутся через file_io, а не в strand
+        bool async_file_io_ = false;
+        bool snapshot_writing_ = false;
+        // Потоки для запросов к базе, по одному на соединение пула. Объявлен последним:
+        // разрушается первым и дожидается задач, пока остальные поля ещё живы
+        net::thread_pool blocking_pool_{std::max(1u, std::thread::hardware_concurrency())};
+
+        void AddSession(std::shared_ptr<GameSession> session)
+        {
+            sessions_by_map_[session->GetMap()->GetIndex()].push_back(session);
+            sessions_.push_back(std::move(session));
+        }
+
+        // Убирает экземпляры сессий, из которых ушла последняя собака. У карты остаётся
+        // хотя бы один экземпляр, чтобы её трофеи не пропадали, пока на ней никого нет
+        void DropEmptySessions()
+        {
+            bool dropped = false;
+            for (auto &instances : sessions_by_map_)
+            {
+                for (auto it = instances.begin(); it != instances.end() && instances.size() > 1;)
+                {
+                    if ((*it)->GetDogs().empty())
+                    {
+                        it = instances.erase(it);
+                        dropped = true;
+                    }
+                    else
+                    {
+                        ++it;
+                    }
+                }
+            }
+            if (dropped)
+            {
+                std::erase_if(sessions_, [this](const std::shared_ptr<GameSession> &session)
+                              {
+                                  const auto &instances = sessions_by_map_[session->GetMap()->GetIndex()];
+                                  return std::find(instances.begin(), instances.end(), session) == instances.end(); });
+            }
+        }
+
+        // Наименее заполненный экземпляр сессии карты, в котором есть место.
+        // Если все заполнены, создаётся новый экземпляр
+        std::shared_ptr<GameSession> SelectSessionForJoin(model::Map *map)
+        {
+            std::shared_ptr<GameSession> best;
+            for (const auto &session : sessions_by_map_[map->GetIndex()])
+            {
+                const size_t players = session->GetDogs().size();
+                if (max_players_per_session_ != 0 && players >= max_players_per_session_)
+                {
+                    continue;
+                }
+                if (!best || players < best->GetDogs().size())
+                {
+                    best = session;
+                }
+            }
+            if (!best)
+            {
+                best = std::make_shared<GameSession>(map);
+                AddSession(best);
+            }
+            return best;
+        }
+
+        // Новый игрок с собакой на карте: по запросу /game/join или бот
+        Player &JoinPlayer(model::Map *map, std::string_view user_name)
+        {
+            std::shared_ptr<GameSession> session = SelectSessionForJoin(map);
+            std::shared_ptr<Dog> dog = session->AddDog(user_name, randomize_spawn_);
+            session->InvalidateStateSnapshot();
+            players_changed_ = true;
+            return players_.AddPlayer(std::move(session), std::move(dog));
+        }
+
+        template <typename Req, typename Send>
+        void RunEndpoint(const api_router::RouteMatch &match, const Req &req, Send &send)
+        {
+            // Ответ на /game/state может иметь тело другого типа
+            if (match.route->endpoint == api_router::Endpoint::STATE)
+            {
+                HandleGameState(req, match.query, send);
+                return;
+            }
+            send(HandleEndpoint(match, req));
+        }
+        template <typename Req>
+        http::response<http::string_body> HandleEndpoint(const api_router::RouteMatch &match, const Req &req)
+        {
+            switch (match.route->endpoint)
+            {
+            case api_router::Endpoint::MAPS:
+                return HandleMapsList(req);
+            case api_router::Endpoint::MAP_BY_ID:
+                return HandleMapById(req, match.param);
+            case api_router::Endpoint::JOIN:
+                return HandleJoinPlayer(req);
+            case api_router::Endpoint::PLAYERS:
+                return HandlePlayersList(req);
+            case api_router::Endpoint::STATE:
+                // Обрабатывается в RunEndpoint
+                break;
+            case api_router::Endpoint::ACTION:
+                return HandleGameActions(req);
+            case api_router::Endpoint::ACTIONS:
+                return HandleBatchActions(req);
+            case api_router::Endpoint::TICK:
+                return HandleGameTick(req);
+            case api_router::Endpoint::RECORDS:
+                return HandleGameRecords(req, match.query);
+            case api_router::Endpoint::METRICS:
+                return HandleMetrics(req);
+            }
+            return MakeError(http::status::bad_request, "badRequest", "Bad request", req);
+        }
         template <typename Req>
         http::response<http::string_body> HandleMapsList(const Req &req) const
         {
@@ -296,11 +635,11 @@ namespace http_handler
         }
 
         template <typename Req>
-        http::response<http::string_body> HandleMapById(const Req &req) const
+        http::response<http::string_body> HandleMapById(const Req &req, std::string_view map_param) const
         {
 
-            std::string map_id = std::string(req.target()).substr(std::string("/api/v1/maps/").size());
-            if (auto map = game_.FindMap(model::Map::Id{map_id}))
+            const model::Map::Id map_id{std::string(map_param)};
+            if (auto map = game_.FindMap(map_id))
             {
                 json::object map_obj;
                 map_obj["id"] = *map->GetId();
@@ -309,14 +648,12 @@ namespace http_handler
                 map_obj["roads"] = SerializeRoads(map->GetRoads());
                 map_obj["buildings"] = SerializeBuildings(map->GetBuildings());
                 map_obj["offices"] = SerializeOffices(map->GetOffices());
-                try
+                if (const json::array *loot_types = extra_data::GetInstance().GetLootTypes(map_id))
                 {
-                    const json::array &loot_types = *extra_data::GetInstance().GetLootTypes(model::Map::Id{map_id});
-                    map_obj["lootTypes"] = loot_types;
+                    map_obj["lootTypes"] = *loot_types;
                 }
-                catch (const std::exception &e)
+                else
                 {
-                    // Можно логировать или оставить пустым, если поле необязательное
                     map_obj["lootTypes"] = json::array(); // fallback, чтобы было всегда
                 }
                 http::response<http::string_body> res{http::status::ok, req.version()};
@@ -330,7 +667,7 @@ namespace http_handler
 
             return MakeError(http::status::not_found, "mapNotFound", "Map not found", req);
         }
-        json::array SerializeRoads(const std::list<model::Road> &roads) const
+        json::array SerializeRoads(const model::Map::Roads &roads) const
         {
             json::array result;
             for (const auto &road : roads)
@@ -388,47 +725,44 @@ namespace http_handler
                                                     std::string_view msg,
                                                     const Req &req) const
         {
-            json::object obj;
-            obj["code"] = code;
-            obj["message"] = msg;
-
             http::response<http::string_body> res{status, req.version()};
             res.set(http::field::content_type, "application/json");
             res.set(http::field::cache_control, "no-cache");
-            res.body() = json::serialize(obj);
+            // Тело из двух строк собирается напрямую: арена и дерево JSON ему не нужны
+            std::string &body = res.body();
+            body.reserve(code.size() + msg.size() + 32);
+            body += R"({"code":)";
+            body += json::serialize(code);
+            body += R"(,"message":)";
+            body += json::serialize(msg);
+            body += '}';
             res.content_length(res.body().size());
             res.keep_alive(req.keep_alive());
             return res;
         }
+        static json::object MakeErrorObject(const json::storage_ptr &storage, std::string_view code, std::string_view msg)
+        {
+            json::object obj{storage};
+            obj["code"] = code;
+            obj["message"] = msg;
+            return obj;
+        }
         template <typename Req>
         http::response<http::string_body> HandleJoinPlayer(const Req &req)
         {
             using namespace std::literals;
 
-            if (req.method() != http::verb::post)
-            {
-                json::object obj;
-                obj["code"] = "invalidMethod";
-                obj["message"] = "Only POST method is expected";
-                http::response<http::string_body> res{http::status::method_not_allowed, req.version()};
-                res.set(http::field::content_type, "application/json");
-                res.set(http::field::cache_control, "no-cache");
-                res.set(http::field::allow, "POST");
-                res.body() = json::serialize(obj);
-                res.content_length(res.body().size());
-                res.keep_alive(req.keep_alive());
-                return res;
-            }
-
             if (req[http::field::content_type] != "application/json")
             {
                 return MakeError(http::status::bad_request, "invalidArgument", "Expected application/json", req);
             }
 
-            json::value json_body;
+            // Значение создаётся в арене, иначе присваивание скопировало бы документ в кучу
+            RequestArena arena;
+            json::value json_body{arena.Storage()};
             try
             {
-                json_body = json::parse(req.body());
+                json_body = json::parse(req.body(), arena.Storage());
             }
             catch (...)
             {
@@ -455,31 +789,17 @@ namespace http_handler
                 return MakeError(http::status::bad_request, "invalidArgument", "Invalid name", req);
             }
 
-            model::Map *map = const_cast<model::Map *>(game_.FindMap(model::Map::Id{map_id}));
+            model::Map *map = game_.FindMap(model::Map::Id{map_id});
             if (!map)
             {
                 return MakeError(http::status::not_found, "mapNotFound", "Map not found", req);
             }
 
-            auto it = sessions_.find(map_id);
-            std::shared_ptr<GameSession> session;
-            if (it == sessions_.end())
-            {
-                session = std::make_shared<GameSession>(map);
-                sessions_[map_id] = session;
-            }
-            else
-            {
-                session = it->second;
-            }
-            std::shared_ptr<Dog> dog = session->AddDog(user_name, randomize_spawn_);
-            dog->SetBagCapacityForDog(session->GetMap()->GetBagCapacityForMap());
-            dog->SetRetirementTimeout(session->GetMap()->GetRetirementTime());
-            Player &player = players_.AddPlayer(session, dog);
+            Player &player = JoinPlayer(map, user_name);
 
-            json::object res_obj;
-            res_obj["authToken"] = *player.GetToken().value(); // Token — Tagged<std::string>
-            res_obj["playerId"] = dog->GetId();                // id собаки = id игрока
+            json::object res_obj{arena.Storage()};
+            res_obj["authToken"] = player.GetToken().ToHex();
+            res_obj["playerId"] = player.GetDog()->GetId();    // id собаки = id игрока
 
             http::response<http::string_body> res{http::status::ok, req.version()};
             res.set(http::field::content_type, "application/json");
@@ -494,21 +814,6 @@ namespace http_handler
         {
             using namespace std::literals;
 
-            if (req.method() != http::verb::get && req.method() != http::verb::head)
-            {
-                json::object obj;
-                obj["code"] = "invalidMethod";
-                obj["message"] = "Invalid method";
-                http::response<http::string_body> res{http::status::method_not_allowed, req.version()};
-                res.set(http::field::content_type, "application/json");
-                res.set(http::field::cache_control, "no-cache");
-                res.set(http::field::allow, "GET, HEAD");
-                res.body() = json::serialize(obj);
-                res.content_length(res.body().size());
-                res.keep_alive(req.keep_alive());
-                return res;
-            }
-
             http::response<http::string_body> err;
             auto player_opt = TryExtractPlayer(req, err);
             if (!player_opt)
@@ -516,73 +821,193 @@ namespace http_handler
 
             Player *player = *player_opt;
 
-            // model::Map::Id map_id = player->GetSession()->GetMap()->GetId();
+            // Видны только игроки из сессии вызывающего
+            std::string response_body = SerializeSessionPlayers(*player->GetSession());
 
-            json::object response_body;
-            for (const auto &player_ptr : players_.GetPlayers())
+            http::response<http::string_body> res{http::status::ok, req.version()};
+            res.set(http::field::content_type, "application/json");
+            res.set(http::field::cache_control, "no-cache");
+            res.content_length(response_body.size()); // нужно указать Content-Length, даже если тело не отправляется
+            if (req.method() != http::verb::head)
+            {
+                res.body() = std::move(response_body);
+            }
+            res.keep_alive(req.keep_alive());
+            return res;
+        }
+        // Ответ /game/state. Если область видимости не задана, отдаётся снимок
+        // состояния сессии, который собирается заново только после её изменения
+        template <typename Req, typename Send>
+        void HandleGameState(const Req &req, std::string_view query, Send &&send) const
+        {
+            http::response<http::string_body> err;
+            auto player_opt = TryExtractPlayer(req, err);
+            if (!player_opt)
             {
+                send(std::move(err));
+                return;
+            }
 
-                if (!player_ptr)
-                    continue;
+            Player *player = *player_opt;
+            GameSession *session = player->GetSession().get();
 
-                Player *p = player_ptr.get();
+            const auto filter = ParseViewFilter(query, player->GetDog()->GetPosition());
+            if (!filter)
+            {
+                send(MakeError(http::status::bad_request, "invalidArgument", "Invalid view area", req));
+                return;
+            }
 
-                response_body[std::to_string(p->GetDog()->GetId())] = {
-                    {"name", p->GetDog()->GetName()}};
+            if (filter->kind == ViewFilter::Kind::ALL)
+            {
+                auto snapshot = session->GetStateSnapshot();
+                if (!snapshot)
+                {
+                    snapshot = BuildStateSnapshot(*session);
+                    session->PublishStateSnapshot(snapshot);
+                }
+                const StateResponseOptions options = GetStateResponseOptions(req);
+                if (options.gzip)
+                {
+                    // Сжатие не держит strand: ответ собирается в потоке ввода-вывода
+                    net::post(strand_.get_inner_executor(), [this, snapshot = std::move(snapshot), options, send = std::move(send)]() mutable
+                              { send(MakeStateResponse(std::move(snapshot), options)); });
+                    return;
+                }
+                send(MakeStateResponse(std::move(snapshot), options));
+                return;
             }
 
             http::response<http::string_body> res{http::status::ok, req.version()};
             res.set(http::field::content_type, "application/json");
             res.set(http::field::cache_control, "no-cache");
-            if (req.method() != http::verb::head)
+            res.body() = SerializeSessionState(*session, *filter);
+            res.content_length(res.body().size());
+            res.keep_alive(req.keep_alive());
+            send(std::move(res));
+        }
+        // Снимок сессии без захода в strand. nullptr, если снимка нет или запрос
+        // нужно обработать обычным путём (ошибка авторизации, новый игрок, область видимости)
+        template <typename Req>
+        std::shared_ptr<const SessionStateSnapshot> FindCachedSnapshot(const Req &req, std::string_view query) const
+        {
+            using namespace std::literals;
+            const auto filter = ParseViewFilter(query, {});
+            if (!filter || filter->kind != ViewFilter::Kind::ALL)
             {
-                res.body() = json::serialize(response_body);
-                res.content_length(res.body().size());
+                return nullptr;
             }
-            else
+            const auto auth_header = req[http::field::authorization];
+            if (!auth_header.starts_with("Bearer "sv) || auth_header.size() != 7 + 32)
+            {
+                return nullptr;
+            }
+            const auto world = world_snapshot_.load(std::memory_order_acquire);
+            if (!world)
             {
-                res.content_length(json::serialize(response_body).size()); // нужно указать Content-Length, даже если тело не отправляется
+                return nullptr;
+            }
+            const auto token = Token::FromHex(auth_header.substr(7));
+            if (!token)
+            {
+                return nullptr;
+            }
+            const auto it = world->sessions_by_token.find(*token);
+            return it != world->sessions_by_token.end() ? it->second->GetStateSnapshot() : nullptr;
+        }
+        template <typename Req>
+        http::response<http_server::SharedStringBody> MakePlayersResponse(std::shared_ptr<const SessionStateSnapshot> snapshot, const Req &req) const
+        {
+            http::response<http_server::SharedStringBody> res{http::status::ok, req.version()};
+            res.set(http::field::content_type, "application/json");
+            res.set(http::field::cache_control, "no-cache");
+            std::shared_ptr<const std::string> buffer(snapshot, &snapshot->players);
+            res.content_length(buffer->size());
+            if (req.method() != http::verb::head)
+            {
+                res.body() = std::move(buffer);
             }
             res.keep_alive(req.keep_alive());
             return res;
         }
+        // Всё, что ответ из снимка берёт из запроса: запрос не переживает переход в другой поток
+        struct StateResponseOptions
+        {
+            unsigned version;
+            bool keep_alive;
+            bool head;
+            bool gzip;
+        };
         template <typename Req>
-        http::response<http::string_body> HandleGameState(const Req &req) const
+        static StateResponseOptions GetStateResponseOptions(const Req &req)
         {
             using namespace std::literals;
-
-            if (req.method() != http::verb::get && req.method() != http::verb::head)
+            return {req.version(), req.keep_alive(), req.method() == http::verb::head,
+                    req[http::field::accept_encoding].find("gzip"sv) != std::string_view::npos};
+        }
+        http::response<http_server::SharedStringBody> MakeStateResponse(std::shared_ptr<const SessionStateSnapshot> snapshot, const StateResponseOptions &options) const
+        {
+            http::response<http_server::SharedStringBody> res{http::status::ok, options.version};
+            res.set(http::field::content_type, "application/json");
+            res.set(http::field::cache_control, "no-cache");
+            res.set(http::field::vary, "Accept-Encoding");
+            const std::string *body = &snapshot->json;
+            if (options.gzip)
             {
-                json::object obj;
-                obj["code"] = "invalidMethod";
-                obj["message"] = "Invalid method";
-                http::response<http::string_body> res{http::status::method_not_allowed, req.version()};
-                res.set(http::field::content_type, "application/json");
-                res.set(http::field::cache_control, "no-cache");
-                res.set(http::field::allow, "GET, HEAD");
-                res.body() = json::serialize(obj);
-                res.content_length(res.body().size());
-                res.keep_alive(req.keep_alive());
-                return res;
+                res.set(http::field::content_encoding, "gzip");
+                std::call_once(snapshot->gzip_once, [&snapshot]
+                               { snapshot->gzip = GzipCompress(snapshot->json); });
+                body = &snapshot->gzip;
             }
-
-            http::response<http::string_body> err;
-            auto player_opt = TryExtractPlayer(req, err);
-            if (!player_opt)
-                return err;
-
-            Player *player = *player_opt;
-            auto *session = player->GetSession().get();
-            const auto &lost_objects = session->GetLostObjects();
-
+            // Буфер разделяется со снимком, копирования нет
+            std::shared_ptr<const std::string> buffer(snapshot, body);
+            res.content_length(buffer->size());
+            if (!options.head)
+            {
+                res.body() = std::move(buffer);
+            }
+            res.keep_alive(options.keep_alive);
+            return res;
+        }
+        std::shared_ptr<const SessionStateSnapshot> BuildStateSnapshot(const GameSession &session) const
+        {
+            auto snapshot = std::make_shared<SessionStateSnapshot>();
+            snapshot->json = SerializeSessionState(session, ViewFilter{});
+            snapshot->players = SerializeSessionPlayers(session);
+            return snapshot;
+        }
+        std::string SerializeSessionPlayers(const GameSession &session) const
+        {
+            json::object response_body;
+            for (const auto &dog : session.GetDogs())
+            {
+                response_body[std::to_string(dog->GetId())] = {
+                    {"name", dog->GetName()}};
+            }
+            return json::serialize(response_body);
+        }
+        // Публикует соответствие токенов сессиям для чтения вне strand.
+        // Вызывается в strand после изменения состава игроков
+        void PublishWorldSnapshot()
+        {
+            auto world = std::make_shared<WorldSnapshot>();
+            world->sessions_by_token.reserve(players_.GetPlayers().size());
+            for (const auto &player : players_.GetPlayers())
+            {
+                world->sessions_by_token.emplace(player->GetToken(), player->GetSession());
+            }
+            world_snapshot_.store(std::move(world), std::memory_order_release);
+            players_changed_ = false;
+        }
+        std::string SerializeSessionState(const GameSession &session, const ViewFilter &filter) const
+        {
             json::object players_json;
 
-            for (const auto &p : players_.GetPlayers())
+            for (const auto &dog : session.GetDogs())
             {
-                if (!p)
+                if (!filter.Contains(dog->GetPosition()))
                     continue;
 
-                std::shared_ptr<Dog> dog = p->GetDog();
                 std::string dir;
                 json::array pos{
                     static_cast<double>(dog->GetPosition().x),
@@ -627,28 +1052,20 @@ namespace http_handler
             res_body["players"] = players_json;
 
             json::object lost_objects_json;
-            for (const auto &[id, obj] : lost_objects)
+            for (const auto &obj : session.GetLostObjects())
             {
+                if (!filter.Contains(obj.pos))
+                    continue;
                 json::array pos{
                     static_cast<double>(obj.pos.x),
                     static_cast<double>(obj.pos.y)};
-                lost_objects_json[std::to_string(id)] = {
+                lost_objects_json[std::to_string(obj.id)] = {
                     {"type", obj.type},
                     {"pos", pos}};
             }
             res_body["lostObjects"] = lost_objects_json;
 
-            std::ostringstream oss;
-            oss << std::fixed << std::setprecision(1);
-            oss << json::serialize(res_body);
-
-            http::response<http::string_body> res{http::status::ok, req.version()};
-            res.set(http::field::content_type, "application/json");
-            res.set(http::field::cache_control, "no-cache");
-            res.body() = oss.str();
-            res.content_length(res.body().size());
-            res.keep_alive(req.keep_alive());
-            return res;
+            return json::serialize(res_body);
         }
         template <typename Req>
         std::optional<Player *> TryExtractPlayer(const Req &req, http::response<http::string_body> &error_response) const
@@ -660,15 +1077,16 @@ namespace http_handler
                 return std::nullopt;
             }
 
-            const std::string token_str = std::string(auth_header.substr(7));
-            if (token_str.size() != 32)
+            const std::string_view token_str = auth_header.substr(7);
+            if (token_str.size() != Token::HEX_SIZE)
             {
                 error_response = MakeError(http::status::unauthorized, "invalidToken", "Invalid token length", req);
                 return std::nullopt;
             }
 
-            Token token{token_str};
-            Player *player = players_.FindByToken(token);
+            // Строка не из hex-символов не может быть токеном ни одного игрока
+            const auto token = Token::FromHex(token_str);
+            Player *player = token ? players_.FindByToken(*token) : nullptr;
             if (!player)
             {
                 error_response = MakeError(http::status::unauthorized, "unknownToken", "Player token has not been found", req);
@@ -682,30 +1100,16 @@ namespace http_handler
         {
             using namespace std::literals;
 
-            if (req.method() != http::verb::post)
-            {
-                json::object obj;
-                obj["code"] = "invalidMethod";
-                obj["message"] = "Invalid method";
-                http::response<http::string_body> res{http::status::method_not_allowed, req.version()};
-                res.set(http::field::content_type, "application/json");
-                res.set(http::field::cache_control, "no-cache");
-                res.set(http::field::allow, "POST");
-                res.body() = json::serialize(obj);
-                res.content_length(res.body().size());
-                res.keep_alive(req.keep_alive());
-                return res;
-            }
-
             if (req[http::field::content_type] != "application/json")
             {
                 return MakeError(http::status::bad_request, "invalidArgument", "Expected application/json", req);
             }
 
-            json::value json_body;
+            RequestArena arena;
+            json::value json_body{arena.Storage()};
             try
             {
-                json_body = json::parse(req.body());
+                json_body = json::parse(req.body(), arena.Storage());
             }
             catch (...)
             {
@@ -739,57 +1143,142 @@ namespace http_handler
                 return MakeError(http::status::bad_request, "invalidArgument", "Dog not found", req);
             }
 
-            // Устанавливаем направление
-            if (dir == "U")
+            const auto direction = ParseMove(dir);
+            if (!direction)
+            {
+                return MakeError(http::status::bad_request, "invalidArgument", "Invalid direction", req);
+            }
+            const auto session = player->GetSession();
+            session->SteerDog(dog, *direction, session->GetMap()->GetSpeedForThisMap());
+            // Снимок пересоберётся при первом чтении: клиент сразу видит новую скорость
+            session->InvalidateStateSnapshot();
+
+            http::response<http::string_body> res{http::status::ok, req.version()};
+            res.set(http::field::content_type, "application/json");
+            res.set(http::field::cache_control, "no-cache");
+            res.body() = "{}";
+            res.content_length(res.body().size());
+            res.keep_alive(req.keep_alive());
+            return res;
+        }
+        static std::optional<Direction> ParseMove(std::string_view move)
+        {
+            if (move == "U")
             {
-                dog->SetDirection(Direction::NORTH);
+                return Direction::NORTH;
             }
-            else if (dir == "D")
+            if (move == "D")
             {
-                dog->SetDirection(Direction::SOUTH);
+                return Direction::SOUTH;
             }
-            else if (dir == "L")
+            if (move == "L")
             {
-                dog->SetDirection(Direction::WEST);
+                return Direction::WEST;
             }
-            else if (dir == "R")
+            if (move == "R")
             {
-                dog->SetDirection(Direction::EAST);
+                return Direction::EAST;
             }
-            else
+            return std::nullopt;
+        }
+        // Пакет действий [{"token": ..., "move": ...}, ...] от шлюза, ведущего многих игроков.
+        // Все действия применяются за один заход в strand, в ответе на каждое — {}
+        // или объект ошибки, такой же, как в ответе /game/player/action
+        template <typename Req>
+        http::response<http::string_body> HandleBatchActions(const Req &req)
+        {
+            if (req[http::field::content_type] != "application/json")
             {
-                return MakeError(http::status::bad_request, "invalidArgument", "Invalid direction", req);
+                return MakeError(http::status::bad_request, "invalidArgument", "Expected application/json", req);
+            }
+
+            RequestArena arena;
+            json::value json_body{arena.Storage()};
+            try
+            {
+                json_body = json::parse(req.body(), arena.Storage());
+            }
+            catch (...)
+            {
+                return MakeError(http::status::bad_request, "invalidArgument", "Failed to parse request body", req);
+            }
+
+            const json::array *entries = json_body.if_array();
+            if (!entries)
+            {
+                return MakeError(http::status::bad_request, "invalidArgument", "Expected JSON array", req);
+            }
+
+            json::array results{arena.Storage()};
+            results.reserve(entries->size());
+            for (const json::value &entry : *entries)
+            {
+                results.emplace_back(ApplyBatchAction(entry, arena.Storage()));
             }
-            const double speed = player->GetSession()->GetMap()->GetSpeedForThisMap();
-            dog->SetSpeed(speed);
 
             http::response<http::string_body> res{http::status::ok, req.version()};
             res.set(http::field::content_type, "application/json");
             res.set(http::field::cache_control, "no-cache");
-            res.body() = "{}";
+            res.body() = json::serialize(results);
             res.content_length(res.body().size());
             res.keep_alive(req.keep_alive());
             return res;
         }
-        template <typename Req>
-        http::response<http::string_body> HandleGameTick(const Req &req)
+        json::object ApplyBatchAction(const json::value &entry, const json::storage_ptr &storage)
         {
-            using namespace std::literals;
+            const json::object *obj = entry.if_object();
+            if (!obj)
+            {
+                return MakeErrorObject(storage, "invalidArgument", "Expected JSON object");
+            }
+            const json::value *token_value = obj->if_contains("token");
+            const json::value *move_value = obj->if_contains("move");
+            if (!token_value || !token_value->is_string())
+            {
+                return MakeErrorObject(storage, "invalidToken", "Missing or invalid 'token' field");
+            }
+            if (!move_value || !move_value->is_string())
+            {
+                return MakeErrorObject(storage, "invalidArgument", "Missing or invalid 'move' field");
+            }
 
-            if (req.method() != http::verb::post)
+            const std::string_view token_str = token_value->as_string();
+            if (token_str.size() != Token::HEX_SIZE)
             {
-                return MakeError(http::status::method_not_allowed, "invalidMethod", "Only POST method is expected", req);
+                return MakeErrorObject(storage, "invalidToken", "Invalid token length");
+            }
+            const auto token = Token::FromHex(token_str);
+            Player *player = token ? players_.FindByToken(*token) : nullptr;
+            if (!player)
+            {
+                return MakeErrorObject(storage, "unknownToken", "Player token has not been found");
             }
 
+            const auto direction = ParseMove(move_value->as_string());
+            if (!direction)
+            {
+                return MakeErrorObject(storage, "invalidArgument", "Invalid direction");
+            }
+            const auto &session = player->GetSession();
+            session->SteerDog(player->GetDog(), *direction, session->GetMap()->GetSpeedForThisMap());
+            session->InvalidateStateSnapshot();
+            return json::object{storage};
+        }
+        template <typename Req>
+        http::response<http::string_body> HandleGameTick(const Req &req)
+        {
+            using namespace std::literals;
+
             if (req[http::field::content_type] != "application/json")
             {
                 return MakeError(http::status::bad_request, "invalidArgument", "Expected application/json", req);
             }
 
-            json::value json_body;
+            RequestArena arena;
+            json::value json_body{arena.Storage()};
             try
             {
-                json_body = json::parse(req.body());
+                json_body = json::parse(req.body(), arena.Storage());
             }
             catch (...)
             {
@@ -812,55 +1301,7 @@ namespace http_handler
             {
                 return MakeError(http::status::bad_request, "invalidArgument", "timeDelta must be non-negative", req);
             }
-            std::vector<Token> retired_tokens;
-            for (const auto &player_ptr : players_.GetPlayers())
-            {
-                auto dog = player_ptr->GetDog();
-                dog->UpdatePosition(time_delta_ms, player_ptr->GetSession().get());
-                if (dog->IsRetired() && !dog->WasRecorded())
-                {
-                    dog->MarkRecorded();
-
-                    record_repo_->SaveRecord(
-                        dog->GetName(),
-                        dog->GetScore(),
-                        dog->GetLifeTime());
-                }
-                Token token = player_ptr->GetToken().value();
-                retired_tokens.push_back(token);
-            }
-
-            for (const Token &token : retired_tokens)
-            {
-                players_.RemoveByToken(token);
-            }
-            std::chrono::milliseconds delta{time_delta_ms};
-            for (auto &map : game_.GetMaps())
-            {
-                const model::Map::Id map_id = map.GetId();
-                // Реализовать simoltaniousTick
-                // В Generate передается разница во времени между предыдущим Generate и нынешним. Учесть(скорее всего все ок)
-                std::shared_ptr<GameSession> session;
-                try
-                {
-                    session = sessions_.at(*map_id);
-                }
-                catch (...)
-                {
-                    continue;
-                }
-                const int current_loot = static_cast<int>(session->GetLostObjects().size());
-                const int dogs_count = static_cast<int>(session->GetDogs().size());
-
-                auto *generator = extra_data::GetInstance().GetLootGenerator(map_id);
-                const auto *loot_types = extra_data::GetInstance().GetLootTypes(map_id);
-
-                if (generator && loot_types)
-                {
-                    const int new_loot_count = generator->Generate(delta, current_loot, dogs_count);
-                    session->AddRandomLoot(new_loot_count, session->GetMap()->GetRoads(), static_cast<int>(loot_types->size()), *loot_types);
-                }
-            }
+            RunTick(std::chrono::milliseconds{time_delta_ms});
 
             http::response<http::string_body> res{http::status::ok, req.version()};
             res.set(http::field::content_type, "application/json");
@@ -868,119 +1309,128 @@ namespace http_handler
             res.body() = "{}";
             res.content_length(res.body().size());
             res.keep_alive(req.keep_alive());
-            if (save_period_ && state_file_path_)
-            {
-                int prev = accumulated_time_ms_.fetch_add(delta.count()) + delta.count();
-                if (prev >= save_period_->count())
-                {
-                    SaveState();
-                    accumulated_time_ms_ = 0;
-                }
-            }
             return res;
         }
         void SimultaniousTick(std::chrono::milliseconds ms)
         {
             AutoTick_ = true;
-            int millis = static_cast<int>(ms.count());
-            std::vector<Token> retired_tokens;
-            for (const auto &player_ptr : players_.GetPlayers())
+            RunTick(ms);
+        }
+        // Шаг симуляции, общий для ручного и автоматического тика.
+        // Длительность каждой фазы попадает в метрики.
+        void RunTick(std::chrono::milliseconds delta)
+        {
+            metrics::ScopedTimer tick_timer{metrics::Timer::TICK};
+            const int millis = static_cast<int>(delta.count());
+            if (bots_)
+            {
+                metrics::ScopedTimer timer{metrics::Timer::TICK_BOTS};
+                bots_->Act(delta);
+            }
             {
-                auto dog = player_ptr->GetDog();
-                dog->UpdatePosition(millis, player_ptr->GetSession().get());
-                if (dog->IsRetired() && !dog->WasRecorded())
+                metrics::ScopedTimer timer{metrics::Timer::TICK_MOVE};
+                for (const auto &session : sessions_)
                 {
-                    dog->MarkRecorded();
-
-                    record_repo_->SaveRecord(
-                        dog->GetName(),
-                        dog->GetScore(),
-                        dog->GetLifeTime());
-                    Token token = player_ptr->GetToken().value();
-                    retired_tokens.push_back(token);
+                    session->MoveDogs(millis);
                 }
             }
-            for (const Token &token : retired_tokens)
             {
-                players_.RemoveByToken(token);
+                metrics::ScopedTimer timer{metrics::Timer::TICK_GATHER};
+                for (const auto &session : sessions_)
+                {
+                    session->GatherLoot();
+                }
             }
-
-            for (auto &map : game_.GetMaps())
             {
-                const model::Map::Id map_id = map.GetId();
-
-                std::shared_ptr<GameSession> session;
-                try
+                metrics::ScopedTimer timer{metrics::Timer::TICK_RETIRE};
+                // Сессии сами сообщают об ушедших собаках, остальные игроки не просматриваются
+                bool emptied = false;
+                for (const auto &session : sessions_)
                 {
-                    session = sessions_.at(*map_id);
+                    const size_t removed = players_.RemoveRetired(*session, [this](const Dog &dog)
+                                                                  { record_repo_->SaveRecord(
+                                                                        std::string(dog.GetName()),
+                                                                        dog.GetScore(),
+                                                                        dog.GetLifeTime()); });
+                    players_changed_ = players_changed_ || removed > 0;
+                    emptied = emptied || (removed > 0 && session->GetDogs().empty());
                 }
-                catch (...)
+                if (emptied)
                 {
-                    continue;
+                    DropEmptySessions();
                 }
-                const int current_loot = static_cast<int>(session->GetLostObjects().size());
-                const int dogs_count = static_cast<int>(session->GetDogs().size());
-
-                auto *generator = extra_data::GetInstance().GetLootGenerator(map_id);
-                const auto *loot_types = extra_data::GetInstance().GetLootTypes(map_id);
-
-                if (generator && loot_types)
+            }
+            {
+                metrics::ScopedTimer timer{metrics::Timer::TICK_LOOT_SPAWN};
+                for (const auto &session : sessions_)
                 {
-                    const int new_loot_count = generator->Generate(ms, current_loot, dogs_count);
-                    session->AddRandomLoot(new_loot_count, session->GetMap()->GetRoads(), static_cast<int>(loot_types->size()), *loot_types);
+                    session->SpawnLoot(delta);
+                }
+            }
+            {
+                metrics::ScopedTimer timer{metrics::Timer::TICK_STATE_CACHE};
+                for (const auto &session : sessions_)
+                {
+                    session->InvalidateStateSnapshot();
+                }
+                // Новые игроки становятся видны чтению вне strand не позже следующего тика
+                if (players_changed_)
+                {
+                    PublishWorldSnapshot();
                 }
             }
             if (save_period_ && state_file_path_)
             {
-                int prev = accumulated_time_ms_.fetch_add(ms.count()) + ms.count();
+                metrics::ScopedTimer timer{metrics::Timer::TICK_SAVE};
+                int prev = accumulated_time_ms_.fetch_add(delta.count()) + delta.count();
                 if (prev >= save_period_->count())
                 {
-                    SaveState();
+                    if (async_file_io_)
+                    {
+                        SaveStateAsync();
+                    }
+                    else
+                    {
+                        SaveState();
+                    }
                     accumulated_time_ms_ = 0;
                 }
             }
         }
         template <typename Req>
-        http::response<http::string_body> HandleGameRecords(const Req &req)
+        http::response<http::string_body> HandleMetrics(const Req &req) const
         {
-            using namespace std::literals;
-
-            if (req.method() != http::verb::get)
+            std::string body = metrics::RenderPrometheus();
+            if (const auto &sink = LogSink())
             {
-                return MakeError(http::status::method_not_allowed, "invalidMethod", "Only GET method is allowed", req);
+                body += "# HELP game_log_dropped_records_total Log records dropped because the log queue was full\n";
+                body += "# TYPE game_log_dropped_records_total counter\n";
+                body += "game_log_dropped_records_total " + std::to_string(sink->locked_backend()->GetDroppedCount()) + "\n";
             }
 
-            // Парсим query-параметры
-            std::string query = std::string{req.target()};
-            auto pos = query.find('?');
-            std::string query_str = (pos != std::string::npos) ? query.substr(pos + 1) : "";
-
-            std::unordered_map<std::string, std::string> params;
-            std::istringstream iss(query_str);
-            for (std::string token; std::getline(iss, token, '&');)
+            http::response<http::string_body> res{http::status::ok, req.version()};
+            res.set(http::field::content_type, "text/plain; version=0.0.4");
+            res.set(http::field::cache_control, "no-cache");
+            res.content_length(body.size());
+            if (req.method() != http::verb::head)
             {
-                auto eq = token.find('=');
-                if (eq != std::string::npos)
-                {
-                    params[token.substr(0, eq)] = token.substr(eq + 1);
-                }
+                res.body() = std::move(body);
             }
+            res.keep_alive(req.keep_alive());
+            return res;
+        }
+        template <typename Req>
+        http::response<http::string_body> HandleGameRecords(const Req &req, std::string_view query)
+        {
+            using namespace std::literals;
 
             size_t start = 0;
             size_t max_items = 100;
 
-            try
-            {
-                if (params.count("start"))
-                {
-                    start = std::stoul(params["start"]);
-                }
-                if (params.count("maxItems"))
-                {
-                    max_items = std::stoul(params["maxItems"]);
-                }
-            }
-            catch (...)
+            const auto start_param = api_router::FindQueryParam(query, "start"sv);
+            const auto max_items_param = api_router::FindQueryParam(query, "maxItems"sv);
+            if ((start_param && !api_router::ParseUnsigned(*start_param, start)) ||
+                (max_items_param && !api_router::ParseUnsigned(*max_items_param, max_items)))
             {
                 return MakeError(http::status::bad_request, "invalidArgument", "start and maxItems must be integers", req);
             }
@@ -994,13 +1444,16 @@ namespace http_handler
             const auto records = record_repo_->GetRecords(start, max_items);
 
             // Собираем JSON
-            boost::json::array json_arr;
+            RequestArena arena;
+            boost::json::array json_arr{arena.Storage()};
+            json_arr.reserve(records.size());
             for (const auto &r : records)
             {
                 json_arr.emplace_back(boost::json::object{
-                    {"name", r.name},
-                    {"score", r.score},
-                    {"playTime", r.play_time}});
+                    {{"name", r.name},
+                     {"score", r.score},
+                     {"playTime", r.play_time}},
+                    arena.Storage()});
             }
 
             std::string body = boost::json::serialize(json_arr);
@@ -1024,14 +1477,31 @@ namespace http_handler
                        bool randomize_spawn,
                        std::optional<std::filesystem::path> state_file_path,
                        std::optional<std::chrono::milliseconds> save_period,
-                       std::shared_ptr<database::RecordRepository> record_repo)
+                       std::shared_ptr<database::RecordRepository> record_repo,
+                       size_t max_players_per_session = 0,
+                       bots::Settings bot_settings = {},
+                       bool async_file_io = false)
             : game_{game},
               static_root_{std::move(static_root)},
-              api_handler_(game, strand, randomize_spawn, state_file_path, save_period, std::move(record_repo)),
-              randomize_spawn_{randomize_spawn} {}
+              api_handler_(game, strand, randomize_spawn, state_file_path, save_period, std::move(record_repo), max_players_per_session, bot_settings, async_file_io),
+              randomize_spawn_{randomize_spawn},
+              async_file_io_{async_file_io} {}
+
+        // Исполнитель для send, с которым сессия не связала свой исполнитель
+        net::io_context::executor_type GetDefaultExecutor() const
+        {
+            return api_handler_.strand_.get_inner_executor();
+        }
 
         template <typename Body, typename Allocator, typename Send>
         void operator()(http::request<Body, http::basic_fields<Allocator>> &&req, Send &&send)
+        {
+            const api_router::RouteMatch match = api_router::Match(req.target());
+            (*this)(std::move(req), std::forward<Send>(send), match);
+        }
+        // match — уже разобранная цель запроса, см. ApiRequestHandler::HandleRequest
+        template <typename Body, typename Allocator, typename Send>
+        void operator()(http::request<Body, http::basic_fields<Allocator>> &&req, Send &&send, const api_router::RouteMatch &match)
         {
             using namespace std::literals;
 
@@ -1070,11 +1540,9 @@ namespace http_handler
                 return res;
             };
 
-            const std::string target = std::string(req.target());
-
-            if (target.starts_with("/api/"))
+            if (req.target().starts_with("/api/"sv))
             {
-                api_handler_.HandleRequest(req, std::forward<Send>(send));
+                api_handler_.HandleRequest(std::move(req), std::forward<Send>(send), match);
                 return;
             }
 
@@ -1097,6 +1565,36 @@ namespace http_handler
                 return send(not_found_file());
             }
 
+            if (async_file_io_)
+            {
+                // Файл читает io_context сессии: в режиме --io-contexts чтение остаётся на её ядре.
+                // Исполнитель берётся до того, как send переедет в обработчик
+                const auto executor = net::get_associated_executor(send, GetDefaultExecutor());
+                file_io::AsyncReadFile(executor, full_path,
+                                       [version = req.version(), keep_alive = req.keep_alive(), get = req.method() == http::verb::get,
+                                        mime = GetMimeType(full_path), send = std::forward<Send>(send)](sys::error_code ec, std::string body) mutable
+                                       {
+                                           if (ec)
+                                           {
+                                               http::response<http::string_body> res{http::status::not_found, version};
+                                               res.set(http::field::content_type, "text/plain");
+                                               res.body() = "File not found";
+                                               res.prepare_payload();
+                                               send(std::move(res));
+                                               return;
+                                           }
+                                           http::response<http::string_body> res{http::status::ok, version};
+                                           res.set(http::field::content_type, mime);
+                                           res.content_length(body.size());
+                                           if (get)
+                                           {
+                                               res.body() = std::move(body);
+                                           }
+                                           res.keep_alive(keep_alive);
+                                           send(std::move(res)); });
+                return;
+            }
+
             std::ifstream file(full_path, std::ios::binary);
             std::ostringstream ss;
             ss << file.rdbuf();
@@ -1126,6 +1624,7 @@ namespace http_handler
         fs::path static_root_;
         ApiRequestHandler api_handler_;
         bool randomize_spawn_;
+        bool async_file_io_ = false;
         std::string UrlDecode(std::string_view str) const
         {
             std::ostringstream result;
@@ -1173,23 +1672,41 @@ namespace http_handler
     class LoggingRequestHandler
     {
     public:
-        explicit LoggingRequestHandler(RequestHandler &decorated)
-            : decorated_{decorated} {}
+        explicit LoggingRequestHandler(RequestHandler &decorated, unsigned sample_every = 1)
+            : decorated_{decorated}, sampler_{sample_every} {}
 
         template <typename Body, typename Allocator, typename Send>
         void operator()(http::request<Body, http::basic_fields<Allocator>> &&req,
                         Send &&send,
                         const std::string &ip)
         {
-            auto start = std::chrono::steady_clock::now();
+            const auto start = std::chrono::steady_clock::now();
+            // Цель разбирается один раз: маршрут нужен и для метрик, и для диспетчера API
+            const api_router::RouteMatch match = api_router::Match(req.target());
+            const size_t route = metrics::RouteIndex(req.target(), match);
+
+            // Обёртки сохраняют исполнитель, связанный с send: по нему обработчик узнаёт сессию
+            const auto executor = net::get_associated_executor(send, decorated_.GetDefaultExecutor());
+
+            // Невыбранные запросы не логируем вовсе, чтобы не собирать для них JSON
+            if (!sampler_.Take())
+            {
+                decorated_(std::move(req), net::bind_executor(executor, [start, route, send = std::forward<Send>(send)](auto &&response) mutable
+                                                              {
+                    metrics::ObserveRequest(route, std::chrono::steady_clock::now() - start);
+                    send(std::forward<decltype(response)>(response)); }),
+                           match);
+                return;
+            }
 
             LogRequest(ip, std::string(req.target()), std::string(req.method_string()));
 
-            auto wrapped_send = [this, start, &send, &ip](auto &&response)
+            // Ответ может быть отправлен позже из strand, поэтому send и ip захватываются по значению
+            auto wrapped_send = [this, start, route, send = std::forward<Send>(send), ip](auto &&response) mutable
             {
-                auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-                              std::chrono::steady_clock::now() - start)
-                              .count();
+                const auto elapsed = std::chrono::steady_clock::now() - start;
+                metrics::ObserveRequest(route, elapsed);
+                auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
                 std::optional<std::string> content_type;
                 if (response.find(http::field::content_type) != response.end())
                 {
@@ -1199,11 +1716,12 @@ namespace http_handler
                 send(std::forward<decltype(response)>(response));
             };
 
-            decorated_(std::move(req), std::move(wrapped_send));
+            decorated_(std::move(req), net::bind_executor(executor, std::move(wrapped_send)), match);
         }
 
     private:
         RequestHandler &decorated_;
+        async_log::Sampler sampler_;
 
         void LogRequest(const std::string &ip, const std::string &uri, const std::string &method)
         {
@@ -1271,8 +1789,15 @@ namespace http_handler
                 {
                     handler_(delta);
                 }
+                catch (const std::exception &ex)
+                {
+                    metrics::Add(metrics::Counter::TICK_ERRORS);
+                    BOOST_LOG_TRIVIAL(error) << logging::add_value(additional_data, json::object{{"exception", ex.what()}}) << "tick failed";
+                }
                 catch (...)
                 {
+                    metrics::Add(metrics::Counter::TICK_ERRORS);
+                    BOOST_LOG_TRIVIAL(error) << "tick failed";
                 }
                 ScheduleTick();
             }
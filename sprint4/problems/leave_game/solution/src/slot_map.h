@@ -0,0 +1,137 @@
+#pragma once
+#include <cstdint>
+#include <memory_resource>
+#include <utility>
+#include <vector>
+
+namespace util {
+
+/*
+ *  Плотное хранилище с устойчивыми дескрипторами.
+ *  Элементы лежат в одном непрерывном массиве, поэтому обход — линейный проход по памяти.
+ *  Дескриптор указывает на слот, а слот — на позицию элемента в массиве. Удаление
+ *  переносит последний элемент на место удалённого и увеличивает поколение слота:
+ *  старые дескрипторы удалённого элемента после этого ничего не находят.
+ */
+template <typename T>
+class SlotMap {
+public:
+    struct Handle {
+        uint32_t index = 0;
+        uint32_t generation = 0;
+
+        bool operator==(const Handle&) const = default;
+    };
+
+    using iterator = typename std::pmr::vector<T>::iterator;
+    using const_iterator = typename std::pmr::vector<T>::const_iterator;
+
+    explicit SlotMap(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : values_{resource}
+        , value_slots_{resource}
+        , slots_{resource} {
+    }
+
+    Handle Insert(T value) {
+        uint32_t slot_index;
+        if (free_head_ != NO_SLOT) {
+            slot_index = free_head_;
+            free_head_ = slots_[slot_index].position;
+        } else {
+            slot_index = static_cast<uint32_t>(slots_.size());
+            slots_.push_back({});
+        }
+        Slot& slot = slots_[slot_index];
+        slot.position = static_cast<uint32_t>(values_.size());
+        values_.push_back(std::move(value));
+        value_slots_.push_back(slot_index);
+        return {slot_index, slot.generation};
+    }
+
+    // false, если элемент уже удалён
+    bool Erase(Handle handle) {
+        if (!Contains(handle)) {
+            return false;
+        }
+        Slot& slot = slots_[handle.index];
+        const uint32_t position = slot.position;
+        const uint32_t last = static_cast<uint32_t>(values_.size() - 1);
+        if (position != last) {
+            values_[position] = std::move(values_[last]);
+            value_slots_[position] = value_slots_[last];
+            slots_[value_slots_[position]].position = position;
+        }
+        values_.pop_back();
+        value_slots_.pop_back();
+
+        ++slot.generation;
+        slot.position = free_head_;
+        free_head_ = handle.index;
+        return true;
+    }
+
+    bool Contains(Handle handle) const noexcept {
+        if (handle.index >= slots_.size()) {
+            return false;
+        }
+        // Свободный слот хранит ссылку на список свободных, а не позицию своего элемента
+        const Slot& slot = slots_[handle.index];
+        return slot.generation == handle.generation && slot.position < values_.size()
+            && value_slots_[slot.position] == handle.index;
+    }
+
+    T* Find(Handle handle) noexcept {
+        return Contains(handle) ? &values_[slots_[handle.index].position] : nullptr;
+    }
+    const T* Find(Handle handle) const noexcept {
+        return Contains(handle) ? &values_[slots_[handle.index].position] : nullptr;
+    }
+
+    // Дескриптор элемента, стоящего на позиции position при обходе
+    Handle GetHandle(size_t position) const noexcept {
+        const uint32_t slot_index = value_slots_[position];
+        return {slot_index, slots_[slot_index].generation};
+    }
+
+    void Reserve(size_t size) {
+        values_.reserve(size);
+        value_slots_.reserve(size);
+        slots_.reserve(size);
+    }
+
+    size_t size() const noexcept {
+        return values_.size();
+    }
+    bool empty() const noexcept {
+        return values_.empty();
+    }
+
+    iterator begin() noexcept {
+        return values_.begin();
+    }
+    iterator end() noexcept {
+        return values_.end();
+    }
+    const_iterator begin() const noexcept {
+        return values_.begin();
+    }
+    const_iterator end() const noexcept {
+        return values_.end();
+    }
+
+private:
+    static constexpr uint32_t NO_SLOT = UINT32_MAX;
+
+    struct Slot {
+        // Для занятого слота — позиция элемента, для свободного — следующий свободный слот
+        uint32_t position = 0;
+        uint32_t generation = 0;
+    };
+
+    std::pmr::vector<T> values_;
+    std::pmr::vector<uint32_t> value_slots_;
+    std::pmr::vector<Slot> slots_;
+    uint32_t free_head_ = NO_SLOT;
+};
+
+}  // namespace util
@@ -4,7 +4,9 @@
 #include <boost/serialization/string.hpp>
 #include <boost/serialization/unordered_map.hpp>
 #include <boost/serialization/utility.hpp> 
-#include <boost/serialization/shared_ptr.hpp> 
+#include <boost/serialization/shared_ptr.hpp>
+#include <boost/serialization/version.hpp>
+#include <optional> 
 
 namespace model {
 
@@ -51,6 +53,23 @@ void serialize(Archive& ar, Tagged<Value, Tag>& tag, const unsigned /*version*/)
 
 } // namespace util
 
+// Токен сохраняется hex-строкой, как и в ранних версиях файла состояния
+template <typename Archive>
+void serialize(Archive& ar, Token& token, const unsigned /*version*/) {
+    std::string hex;
+    if constexpr (Archive::is_saving::value) {
+        hex = token.ToHex();
+    }
+    ar & hex;
+    if constexpr (Archive::is_loading::value) {
+        const auto parsed = Token::FromHex(hex);
+        if (!parsed) {
+            throw std::runtime_error("Invalid token in saved state");
+        }
+        token = *parsed;
+    }
+}
+
 template <typename Archive>
 void serialize(Archive& ar, GameSession::LostObject& lost_object, const unsigned /*version*/) {
     ar & lost_object.id;
@@ -69,11 +88,12 @@ public:
     , speed_(dog.GetSpeed())
     , direction_(dog.GetDirection())
     , score_(dog.GetScore())
-    , inventory_(dog.GetBag()){}
+    , inventory_(dog.GetBag().begin(), dog.GetBag().end()){}
 
-    [[nodiscard]] std::shared_ptr<Dog> Restore() const {
-        auto dog = std::make_shared<Dog>(id_, appeared_name_, position_);
+    [[nodiscard]] std::shared_ptr<Dog> Restore(GameSession& session) const {
+        auto dog = session.CreateDog(id_, appeared_name_, position_);
         dog->SetBagCapacityForDog(bag_capacity_);
+        dog->SetRetirementTimeout(session.GetMap()->GetRetirementTime());
         dog->SetSpeed(speed_.x + speed_.y);
         dog->SetDirection(direction_);
         dog->SetScore(score_);
@@ -114,8 +134,11 @@ public:
     : map_id_(session.GetMap()->GetId())
     , next_dog_id_(session.GetNextDogId())
     , next_loot_id_(session.GetNextLootId())
-    , lost_objects_(session.GetLostObjects())
     {
+        lost_objects_.reserve(session.GetLostObjects().size());
+        for (const auto& obj : session.GetLostObjects()) {
+            lost_objects_.emplace(obj.id, obj);
+        }
         for (const auto& dog : session.GetDogs()) {
             dogs_.emplace_back(*dog);
         }
@@ -123,9 +146,8 @@ public:
 
     std::shared_ptr<GameSession> Restore(model::Map* map) const {
         auto session = std::make_shared<GameSession>(map, std::vector<std::shared_ptr<Dog>>{}, next_dog_id_, next_loot_id_, lost_objects_);
-        auto& dst_dogs = session->AccessDogs();
         for (const auto& dog_repr : dogs_) {
-            dst_dogs.emplace_back(dog_repr.Restore());
+            session->AttachDog(dog_repr.Restore(*session));
         }
         return session;
     }
@@ -152,20 +174,25 @@ private:
 class PlayerRepr {
 public:
     PlayerRepr()
-        : token_(std::string{}),
-        map_id_(std::string{})
+        : map_id_(std::string{})
     {}
 
-    explicit PlayerRepr(const Player& player)
-        : token_(*player.GetToken())
+    // session_index — номер сессии игрока в SerializedState::sessions
+    PlayerRepr(const Player& player, size_t session_index)
+        : token_(player.GetToken())
         , dog_id_(player.GetDog()->GetId())
-        , map_id_(player.GetSession()->GetMap()->GetId()) {}
+        , map_id_(player.GetSession()->GetMap()->GetId())
+        , session_index_(session_index) {}
 
     template <typename Archive>
-    void serialize(Archive& ar, const unsigned /*version*/) {
+    void serialize(Archive& ar, const unsigned version) {
         ar & token_;
         ar & dog_id_;
         ar & map_id_;
+        // В версии 0 у карты была одна сессия, и номер не сохранялся
+        if (version >= 1) {
+            ar & session_index_;
+        }
     }
 
     std::unique_ptr<Player> Restore(const std::shared_ptr<GameSession>& session) const {
@@ -178,6 +205,9 @@ public:
         throw std::runtime_error("Dog not found for PlayerRepr");
     }
     const model::Map::Id& GetMapId() const { return map_id_; }
+    std::optional<size_t> GetSessionIndex() const {
+        return session_index_ == NO_SESSION ? std::nullopt : std::optional<size_t>{session_index_};
+    }
     int GetDogId() const { return dog_id_; }
     const Token& GetToken() const { return token_; }
 
@@ -185,7 +215,10 @@ private:
     Token token_;           // уникальный идентификатор игрока
     int dog_id_;            // ID собаки внутри сессии
     model::Map::Id map_id_;        // ID карты/сессии
+    static constexpr size_t NO_SESSION = static_cast<size_t>(-1);
+    size_t session_index_ = NO_SESSION;
 };
+BOOST_CLASS_VERSION(PlayerRepr, 1)
 struct SerializedState {
     std::vector<SessionRepr> sessions;
     std::vector<PlayerRepr> players;
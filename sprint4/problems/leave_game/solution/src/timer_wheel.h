@@ -0,0 +1,172 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <memory_resource>
+#include <utility>
+#include <vector>
+
+namespace util {
+
+/*
+ *  Иерархическое колесо таймеров с шагом в одну миллисекунду.
+ *  Уровень k хранит таймеры, срабатывающие в пределах текущего оборота уровня k + 1;
+ *  при переходе через границу слота его таймеры перераспределяются на уровни ниже.
+ *  Пустые слоты пропускаются по битовым маскам, поэтому Advance на большой отрезок
+ *  времени стоит пропорционально числу таймеров, а не длине отрезка.
+ *  Отмены нет: устаревшие таймеры отбрасывает обработчик при срабатывании.
+ */
+template <typename T>
+class TimerWheel {
+public:
+    using Time = uint64_t;
+
+    // Память под таймеры берётся из resource и после срабатывания переиспользуется
+    explicit TimerWheel(Time now = 0, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : slots_(LEVELS * SLOTS, resource)
+        , overflow_{resource}
+        , expired_{resource}
+        , scratch_{resource}
+        , firing_{resource}
+        , now_{now} {
+    }
+
+    Time GetTime() const noexcept {
+        return now_;
+    }
+    size_t size() const noexcept {
+        return size_;
+    }
+
+    // Таймер с уже наступившим сроком сработает при следующем Advance
+    void Schedule(Time deadline, T value) {
+        ++size_;
+        Place({deadline, std::move(value)});
+    }
+
+    // Переводит время в now и вызывает on_expired(value, deadline) для всех
+    // таймеров со сроком не позже now в порядке возрастания сроков слотов
+    template <typename Fn>
+    void Advance(Time now, Fn&& on_expired) {
+        FireExpired(on_expired);
+        while (size_ > 0) {
+            const Time next = NextEventTime();
+            if (next > now) {
+                break;
+            }
+            now_ = next;
+            Cascade();
+            FireSlot(slots_[now_ & MASK], 0, now_ & MASK, on_expired);
+            FireExpired(on_expired);
+        }
+        now_ = std::max(now_, now);
+    }
+
+private:
+    static constexpr unsigned BITS = 6;
+    static constexpr unsigned SLOTS = 1u << BITS;
+    static constexpr Time MASK = SLOTS - 1;
+    static constexpr unsigned LEVELS = 4;
+    static constexpr Time NEVER = std::numeric_limits<Time>::max();
+
+    struct Timer {
+        Time deadline;
+        T value;
+    };
+    using Slot = std::pmr::vector<Timer>;
+
+    void Place(Timer timer) {
+        if (timer.deadline <= now_) {
+            expired_.push_back(std::move(timer));
+            return;
+        }
+        const unsigned level = (std::bit_width(timer.deadline ^ now_) - 1) / BITS;
+        if (level >= LEVELS) {
+            overflow_.push_back(std::move(timer));
+            return;
+        }
+        const unsigned slot = static_cast<unsigned>((timer.deadline >> (BITS * level)) & MASK);
+        slots_[level * SLOTS + slot].push_back(std::move(timer));
+        occupied_[level] |= uint64_t{1} << slot;
+    }
+
+    // Ближайший момент, когда срабатывает слот уровня 0 или перераспределяется слот выше
+    Time NextEventTime() const noexcept {
+        for (unsigned level = 0; level < LEVELS; ++level) {
+            const unsigned current = static_cast<unsigned>((now_ >> (BITS * level)) & MASK);
+            const uint64_t later = current + 1 < SLOTS ? occupied_[level] & (~uint64_t{0} << (current + 1)) : 0;
+            if (later != 0) {
+                const unsigned slot = static_cast<unsigned>(std::countr_zero(later));
+                const unsigned span = BITS * (level + 1);
+                return ((now_ >> span) << span) | (Time{slot} << (BITS * level));
+            }
+        }
+        if (!overflow_.empty()) {
+            return ((now_ >> (BITS * LEVELS)) + 1) << (BITS * LEVELS);
+        }
+        return NEVER;
+    }
+
+    // Вызывается, когда now_ стоит на начале слота: его таймеры опускаются на уровни ниже
+    void Cascade() {
+        if ((now_ & ((Time{1} << (BITS * LEVELS)) - 1)) == 0) {
+            std::swap(scratch_, overflow_);
+            Replace();
+        }
+        for (unsigned level = LEVELS - 1; level > 0; --level) {
+            if ((now_ & ((Time{1} << (BITS * level)) - 1)) != 0) {
+                continue;
+            }
+            const unsigned slot = static_cast<unsigned>((now_ >> (BITS * level)) & MASK);
+            std::swap(scratch_, slots_[level * SLOTS + slot]);
+            occupied_[level] &= ~(uint64_t{1} << slot);
+            Replace();
+        }
+    }
+
+    void Replace() {
+        for (auto& timer : scratch_) {
+            Place(std::move(timer));
+        }
+        scratch_.clear();
+    }
+
+    template <typename Fn>
+    void FireSlot(Slot& slot, unsigned level, unsigned index, Fn& on_expired) {
+        occupied_[level] &= ~(uint64_t{1} << index);
+        Fire(slot, on_expired);
+    }
+
+    template <typename Fn>
+    void FireExpired(Fn& on_expired) {
+        Fire(expired_, on_expired);
+    }
+
+    // Обработчик может ставить новые таймеры, поэтому срабатывающие уносятся в отдельный буфер
+    template <typename Fn>
+    void Fire(Slot& slot, Fn& on_expired) {
+        if (slot.empty()) {
+            return;
+        }
+        std::swap(firing_, slot);
+        size_ -= firing_.size();
+        for (auto& timer : firing_) {
+            on_expired(timer.value, timer.deadline);
+        }
+        firing_.clear();
+    }
+
+    // Слот slot уровня level хранится по индексу level * SLOTS + slot
+    std::pmr::vector<Slot> slots_;
+    std::array<uint64_t, LEVELS> occupied_{};
+    Slot overflow_;
+    Slot expired_;
+    Slot scratch_;
+    Slot firing_;
+    Time now_;
+    size_t size_ = 0;
+};
+
+}  // namespace util
@@ -0,0 +1,147 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+
+#ifdef __linux__
+#include <sys/random.h>
+#endif
+
+/*
+ *  Токен игрока: 16 случайных байт, хранящихся прямо в объекте.
+ *  В API передаётся как 32 шестнадцатеричных символа в нижнем регистре.
+ */
+class Token {
+public:
+    static constexpr size_t SIZE = 16;
+    static constexpr size_t HEX_SIZE = SIZE * 2;
+    using Bytes = std::array<uint8_t, SIZE>;
+
+    Token() = default;
+    explicit Token(const Bytes& bytes) noexcept
+        : bytes_{bytes} {
+    }
+
+    // Новый случайный токен из общего криптостойкого генератора
+    static Token Generate();
+
+    // nullopt, если строка не является 32-символьной hex-записью
+    static std::optional<Token> FromHex(std::string_view hex) noexcept {
+        if (hex.size() != HEX_SIZE) {
+            return std::nullopt;
+        }
+        Bytes bytes;
+        for (size_t i = 0; i < SIZE; ++i) {
+            const int hi = HexDigitValue(hex[i * 2]);
+            const int lo = HexDigitValue(hex[i * 2 + 1]);
+            if (hi < 0 || lo < 0) {
+                return std::nullopt;
+            }
+            bytes[i] = static_cast<uint8_t>((hi << 4) | lo);
+        }
+        return Token{bytes};
+    }
+
+    std::string ToHex() const {
+        static constexpr char DIGITS[] = "0123456789abcdef";
+        std::string hex(HEX_SIZE, '\0');
+        for (size_t i = 0; i < SIZE; ++i) {
+            hex[i * 2] = DIGITS[bytes_[i] >> 4];
+            hex[i * 2 + 1] = DIGITS[bytes_[i] & 0x0F];
+        }
+        return hex;
+    }
+
+    const Bytes& GetBytes() const noexcept {
+        return bytes_;
+    }
+
+    bool operator==(const Token&) const = default;
+
+private:
+    static constexpr int HexDigitValue(char c) noexcept {
+        if (c >= '0' && c <= '9') {
+            return c - '0';
+        }
+        if (c >= 'a' && c <= 'f') {
+            return c - 'a' + 10;
+        }
+        return -1;
+    }
+
+    Bytes bytes_{};
+};
+
+// Байты токена случайны, поэтому их первых 8 байт достаточно в качестве хеша
+struct TokenHasher {
+    size_t operator()(const Token& token) const noexcept {
+        uint64_t value;
+        std::memcpy(&value, token.GetBytes().data(), sizeof(value));
+        return static_cast<size_t>(value);
+    }
+};
+
+/*
+ *  Источник случайных байт для токенов, общий для всех игроков.
+ *  Байты берутся у ядра (getrandom) блоками, так что на один токен
+ *  в среднем приходится доля системного вызова.
+ */
+class TokenRandom {
+public:
+    void Fill(uint8_t* out, size_t size) {
+        std::lock_guard lock{mutex_};
+        while (size > 0) {
+            if (pos_ == buffer_.size()) {
+                Refill();
+            }
+            const size_t chunk = std::min(size, buffer_.size() - pos_);
+            std::memcpy(out, buffer_.data() + pos_, chunk);
+            // Выданные байты не должны остаться в памяти генератора
+            std::memset(buffer_.data() + pos_, 0, chunk);
+            pos_ += chunk;
+            out += chunk;
+            size -= chunk;
+        }
+    }
+
+    static TokenRandom& GetInstance() {
+        static TokenRandom instance;
+        return instance;
+    }
+
+private:
+    void Refill() {
+        size_t filled = 0;
+#ifdef __linux__
+        while (filled < buffer_.size()) {
+            const ssize_t n = getrandom(buffer_.data() + filled, buffer_.size() - filled, 0);
+            if (n <= 0) {
+                break;
+            }
+            filled += static_cast<size_t>(n);
+        }
+#endif
+        // Запасной путь для других платформ и на случай ошибки getrandom
+        std::random_device device;
+        for (; filled < buffer_.size(); filled += sizeof(unsigned)) {
+            const unsigned value = device();
+            std::memcpy(buffer_.data() + filled, &value, std::min(sizeof(value), buffer_.size() - filled));
+        }
+        pos_ = 0;
+    }
+
+    std::mutex mutex_;
+    std::array<uint8_t, 4096> buffer_{};
+    size_t pos_ = buffer_.size();
+};
+
+inline Token Token::Generate() {
+    Bytes bytes;
+    TokenRandom::GetInstance().Fill(bytes.data(), bytes.size());
+    return Token{bytes};
+}
@@ -0,0 +1,118 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/bots.h"
+
+using namespace std::literals;
+
+SCENARIO("Bots keep their dogs busy and replace retired ones") {
+    using model::Map;
+    using model::Road;
+
+    GIVEN("a looted map and a population of collecting bots") {
+        Map map{Map::Id{"map1"s}, "Map 1"s};
+        map.AddRoad(Road{Road::HORIZONTAL, {0, 0}, 20});
+        map.AddRoad(Road{Road::VERTICAL, {20, 0}, 20});
+        map.AddRoad(Road{Road::HORIZONTAL, {20, 20}, 0});
+        map.AddRoad(Road{Road::VERTICAL, {0, 20}, 0});
+        map.AddOffice(model::Office{model::Office::Id{"o1"s}, {10, 0}, {0, 0}});
+        map.SetLootTypes({{10, 1}});
+        map.SetLootGenerator(loot_gen::LootGenerator{1s, 1.0});
+        map.SetSpeedForThisMap(4.0);
+        map.SetRetirementTime(2.0);
+
+        auto session = std::make_shared<GameSession>(&map);
+        session->SeedRandom(7);
+        int joins = 0;
+        bots::BotPopulation population{
+            {20, bots::Policy::COLLECT}, 1,
+            [&](size_t map_index, std::string_view name) {
+                CHECK(map_index == 0);
+                ++joins;
+                return bots::Joined{session, session->AddDog(name, true)};
+            },
+            11};
+
+        // Тик сервера без HTTP: боты, движение, подбор, уход на покой, новые трофеи
+        auto run_ticks = [&](int count) {
+            for (int i = 0; i < count; ++i) {
+                population.Act(50ms);
+                session->MoveDogs(50);
+                session->GatherLoot();
+                for (const auto& dog : session->GetRetiredDogs()) {
+                    session->RemoveDog(dog->GetId());
+                }
+                session->ClearRetiredDogs();
+                session->SpawnLoot(50ms);
+            }
+        };
+
+        WHEN("the first tick runs") {
+            run_ticks(1);
+            THEN("every bot joins with a dog") {
+                CHECK(joins == 20);
+                CHECK(session->GetDogs().size() == 20);
+            }
+        }
+
+        WHEN("bots play for a few minutes") {
+            run_ticks(4000);
+            THEN("abandoned dogs retire and new bots take their place") {
+                CHECK(joins > 20);
+                CHECK(session->GetDogs().size() <= 20);
+                CHECK(session->GetDogs().size() >= 15);
+            }
+            THEN("bots deliver loot to the office") {
+                int score = 0;
+                for (const auto& dog : session->GetDogs()) {
+                    score += dog->GetScore();
+                }
+                CHECK(score > 0);
+            }
+        }
+    }
+}
+
+SCENARIO("Bots rejoin into fresh instances after their old ones are dropped") {
+    using model::Map;
+    using model::Road;
+
+    GIVEN("bots that get a new session instance on every join") {
+        Map map{Map::Id{"map1"s}, "Map 1"s};
+        map.AddRoad(Road{Road::HORIZONTAL, {0, 0}, 20});
+        map.SetSpeedForThisMap(4.0);
+        map.SetRetirementTime(1.0);
+
+        // Как DropEmptySessions: экземпляр без собак сервер больше не держит
+        std::vector<std::shared_ptr<GameSession>> instances;
+        int joins = 0;
+        bots::BotPopulation population{
+            {3, bots::Policy::WANDER}, 1,
+            [&](size_t, std::string_view name) {
+                ++joins;
+                auto session = std::make_shared<GameSession>(&map);
+                instances.push_back(session);
+                return bots::Joined{session, session->AddDog(name)};
+            },
+            5};
+
+        WHEN("bots abandon their dogs and the emptied instances are dropped") {
+            for (int i = 0; i < 20000 && joins < 10; ++i) {
+                population.Act(50ms);
+                for (const auto& session : instances) {
+                    session->MoveDogs(50);
+                    for (const auto& dog : session->GetRetiredDogs()) {
+                        session->RemoveDog(dog->GetId());
+                    }
+                    session->ClearRetiredDogs();
+                }
+                std::erase_if(instances, [](const std::shared_ptr<GameSession>& session) {
+                    return session->GetDogs().empty();
+                });
+            }
+            THEN("the bots rejoin and only live instances remain") {
+                CHECK(joins >= 10);
+                CHECK(instances.size() <= 3);
+            }
+        }
+    }
+}
@@ -0,0 +1,49 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/objects.h"
+
+using namespace std::literals;
+
+SCENARIO("Dogs gather loot and drop it off at offices along their path") {
+    using model::Map;
+    using model::Road;
+
+    GIVEN("a road with an office in the middle") {
+        Map map{Map::Id{"map1"s}, "Map 1"s};
+        map.AddRoad(Road{Road::HORIZONTAL, {0, 0}, 20});
+        map.AddOffice(model::Office{model::Office::Id{"o1"s}, {10, 0}, {0, 0}});
+        map.SetLootTypes({{10, 1}});
+        map.SetBagCapacityForMap(3);
+        GameSession session{&map};
+
+        auto dog = session.AddDog("dog"s);
+        auto &lost_objects = session.AccessLostObjects();
+        lost_objects.Insert({1, 0, 10, {5.0, 0.0}});
+        lost_objects.Insert({2, 0, 10, {15.0, 0.0}});
+
+        WHEN("the dog runs past the office in one tick") {
+            session.SteerDog(dog, Direction::EAST, 1.0);
+            session.MoveDogs(18'000);
+            session.GatherLoot();
+
+            THEN("loot picked before the office is dropped off, loot after it stays in the bag") {
+                CHECK(lost_objects.empty());
+                REQUIRE(dog->GetBag().size() == 1);
+                CHECK(dog->GetBag().front().first == 2);
+                CHECK(dog->GetScore() == 20);
+            }
+        }
+
+        WHEN("the dog stops short of the office") {
+            session.SteerDog(dog, Direction::EAST, 1.0);
+            session.MoveDogs(9'000);
+            session.GatherLoot();
+
+            THEN("the bag keeps the loot") {
+                REQUIRE(dog->GetBag().size() == 1);
+                CHECK(dog->GetBag().front().first == 1);
+                CHECK(lost_objects.size() == 1);
+            }
+        }
+    }
+}
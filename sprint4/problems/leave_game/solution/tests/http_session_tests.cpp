@@ -0,0 +1,94 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/http_server.h"
+
+#include <boost/asio/read_until.hpp>
+#include <boost/asio/write.hpp>
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <thread>
+
+using namespace std::literals;
+
+namespace {
+
+namespace net = boost::asio;
+namespace http = boost::beast::http;
+using tcp = net::ip::tcp;
+
+using Response = http::response<http::string_body>;
+
+// Свободный порт на loopback: сокет закрывается сразу, а сервер открывает его с reuse_address
+net::ip::port_type FindFreePort() {
+    net::io_context ioc;
+    tcp::acceptor acceptor{ioc, {net::ip::address_v4::loopback(), 0}};
+    return acceptor.local_endpoint().port();
+}
+
+}  // namespace
+
+SCENARIO("A session writes a response sent from another io_context on its own executor") {
+    GIVEN("a server whose handler keeps the send callback instead of answering") {
+        net::io_context server_ioc{1};
+        const tcp::endpoint endpoint{net::ip::address_v4::loopback(), FindFreePort()};
+
+        std::function<void(Response&&)> pending_send;
+        net::execution_context* send_context = nullptr;
+        auto handler = [&](auto&& req, auto&& send, const std::string&) {
+            send_context = &net::query(net::get_associated_executor(send), net::execution::context);
+            pending_send = [send = std::forward<decltype(send)>(send),
+                            version = req.version()](Response&& response) mutable {
+                response.version(version);
+                send(std::move(response));
+            };
+            // Как в режиме --io-contexts: ответ придёт из чужого потока, пока контекст сессии занят
+            server_ioc.stop();
+        };
+        http_server::ServeHttp(server_ioc, endpoint, handler);
+
+        net::io_context client_ioc;
+        tcp::socket client{client_ioc};
+        client.connect(endpoint);
+        net::write(client, net::buffer("GET /api/v1/game/records HTTP/1.1\r\nHost: localhost\r\n\r\n"sv));
+
+        std::thread{[&server_ioc] {
+            server_ioc.run();
+        }}.join();
+        REQUIRE(pending_send);
+
+        THEN("send carries the executor of the session's io_context") {
+            CHECK(send_context == &server_ioc);
+        }
+
+        WHEN("the response is sent from a foreign thread while the session context is stopped") {
+            std::thread{[&pending_send] {
+                Response response{http::status::ok, 11};
+                response.body() = "[]";
+                response.prepare_payload();
+                response.keep_alive(false);
+                pending_send(std::move(response));
+            }}.join();
+
+            THEN("nothing is written until the session context runs again") {
+                std::this_thread::sleep_for(50ms);
+                CHECK(client.available() == 0);
+
+                server_ioc.restart();
+                std::thread server_thread{[&server_ioc] {
+                    server_ioc.run_for(2s);
+                }};
+
+                std::string received;
+                boost::system::error_code ec;
+                net::read_until(client, net::dynamic_buffer(received), "[]", ec);
+                server_thread.join();
+
+                CHECK_FALSE(ec);
+                CHECK(received.starts_with("HTTP/1.1 200 OK"sv));
+                CHECK(received.ends_with("[]"sv));
+            }
+        }
+    }
+}
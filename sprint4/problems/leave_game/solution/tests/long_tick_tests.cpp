@@ -0,0 +1,64 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/objects.h"
+
+#include <cmath>
+
+using namespace std::literals;
+
+SCENARIO("A long tick gives the same result as many short ones") {
+    using model::Map;
+    using model::Road;
+
+    GIVEN("two sessions on a map with a chain of roads") {
+        Map map{Map::Id{"map1"s}, "Map 1"s};
+        map.AddRoad(Road{Road::HORIZONTAL, {0, 0}, 10});
+        map.AddRoad(Road{Road::HORIZONTAL, {10, 0}, 30});
+        map.AddRoad(Road{Road::VERTICAL, {30, 0}, 10});
+        map.AddOffice(model::Office{model::Office::Id{"o1"s}, {20, 0}, {0, 0}});
+        map.SetLootTypes({{10, 1}});
+        map.SetBagCapacityForMap(1);
+        map.SetRetirementTime(15.0);
+
+        auto make_session = [&] {
+            auto session = std::make_shared<GameSession>(&map);
+            auto &lost_objects = session->AccessLostObjects();
+            lost_objects.Insert({1, 0, 10, {5.0, 0.0}});
+            lost_objects.Insert({2, 0, 10, {8.0, 0.0}});
+            lost_objects.Insert({3, 0, 10, {25.0, 0.0}});
+            auto dog = session->AddDog("dog"s);
+            session->SteerDog(dog, Direction::EAST, 2.0);
+            return std::pair{session, dog};
+        };
+        auto [short_session, short_dog] = make_session();
+        auto [long_session, long_dog] = make_session();
+
+        WHEN("one session runs 50 ms ticks and the other one tick of the same length") {
+            constexpr int TOTAL_MS = 60'000;
+            for (int elapsed = 0; elapsed < TOTAL_MS; elapsed += 50) {
+                short_session->MoveDogs(50);
+                short_session->GatherLoot();
+            }
+            long_session->MoveDogs(TOTAL_MS);
+            long_session->GatherLoot();
+
+            THEN("the dog crosses to the next road and stops at the end of the chain") {
+                CHECK(long_dog->GetPosition().x == 30.4);
+                CHECK(long_dog->GetPosition() == short_dog->GetPosition());
+            }
+            THEN("loot is picked up and dropped off in the order it is passed") {
+                CHECK(long_dog->GetScore() == 20);
+                CHECK(long_dog->GetScore() == short_dog->GetScore());
+                CHECK(long_dog->GetBag().size() == short_dog->GetBag().size());
+                CHECK(long_session->GetLostObjects().size() == short_session->GetLostObjects().size());
+            }
+            THEN("both dogs retire with the same play time") {
+                CHECK(long_dog->IsRetired());
+                CHECK(short_dog->IsRetired());
+                // Уход назначается от момента упора: 15.2 с пути и 15 с простоя
+                CHECK(std::abs(long_dog->GetLifeTime() - 30.2) < 1e-6);
+                CHECK(std::abs(short_dog->GetLifeTime() - long_dog->GetLifeTime()) < 1e-6);
+            }
+        }
+    }
+}
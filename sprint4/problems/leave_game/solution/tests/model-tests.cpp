@@ -0,0 +1,73 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/model.h"
+
+using namespace std::literals;
+
+SCENARIO("Position on road network by distance") {
+    using model::Map;
+    using model::Road;
+
+    GIVEN("a map with roads of different length") {
+        Map map{Map::Id{"map1"s}, "Map 1"s};
+        map.AddRoad(Road{Road::HORIZONTAL, {0, 0}, 10});
+        map.AddRoad(Road{Road::VERTICAL, {5, 5}, 5});
+        map.AddRoad(Road{Road::VERTICAL, {10, 0}, -4});
+
+        THEN("total length is a sum of road lengths") {
+            CHECK(map.GetTotalRoadLength() == 14.0);
+        }
+
+        WHEN("distance falls on the first road") {
+            const auto pos = map.GetPointAtRoadDistance(7.5);
+            THEN("point lies on it") {
+                CHECK(pos.x == 7.5);
+                CHECK(pos.y == 0.0);
+            }
+        }
+
+        WHEN("distance falls past zero length road") {
+            const auto pos = map.GetPointAtRoadDistance(11.0);
+            THEN("zero length road is skipped") {
+                CHECK(pos.x == 10.0);
+                CHECK(pos.y == -1.0);
+            }
+        }
+
+        WHEN("distance is at the bounds") {
+            THEN("points are road ends") {
+                CHECK(map.GetPointAtRoadDistance(0.0).x == 0.0);
+                const auto end = map.GetPointAtRoadDistance(map.GetTotalRoadLength());
+                CHECK(end.x == 10.0);
+                CHECK(end.y == -4.0);
+            }
+        }
+
+        WHEN("roads are looked up after the storage grew") {
+            for (int i = 0; i < 100; ++i) {
+                map.AddRoad(Road{Road::HORIZONTAL, {0, 100 + i}, 1});
+            }
+            THEN("road index still finds original roads") {
+                const Road* road = map.FindRoadAtPosition({3, 0}, model::Orientation::HORIZONTAL);
+                REQUIRE(road != nullptr);
+                CHECK(road->GetEnd().x == 10);
+            }
+        }
+    }
+}
+
+SCENARIO("Loot type selection by weight") {
+    using model::Map;
+
+    GIVEN("a map with weighted loot types") {
+        Map map{Map::Id{"map1"s}, "Map 1"s};
+        map.SetLootTypes({{10, 1}, {20, 0}, {30, 3}});
+
+        THEN("types are picked proportionally to weight") {
+            CHECK(map.PickLootType(0.0) == 0);
+            CHECK(map.PickLootType(0.24) == 0);
+            CHECK(map.PickLootType(0.25) == 2);
+            CHECK(map.PickLootType(0.999) == 2);
+        }
+    }
+}
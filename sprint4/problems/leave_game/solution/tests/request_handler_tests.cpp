@@ -0,0 +1,115 @@
+#include <catch2/catch_test_macros.hpp>
+
+// http_server.h первым, как в main.cpp: он переключает beast на std::string_view
+#include "../src/http_server.h"
+#include "../src/request_handler.h"
+
+#include <optional>
+#include <string>
+
+using namespace std::literals;
+
+namespace {
+
+namespace net = boost::asio;
+namespace http = boost::beast::http;
+namespace json = boost::json;
+
+using StringRequest = http::request<http::string_body>;
+
+// Тело ответа любого типа, который отдаёт обработчик API
+std::string BodyText(const http::response<http::string_body>& res) {
+    return res.body();
+}
+std::string BodyText(const http::response<http_server::SharedStringBody>& res) {
+    return res.body() ? *res.body() : std::string{};
+}
+
+class ApiClient {
+public:
+    ApiClient(http_handler::ApiRequestHandler& handler, net::io_context& ioc)
+        : handler_{handler}
+        , ioc_{ioc} {
+    }
+
+    // Выполняет запрос вместе со всеми задачами strand и возвращает тело ответа
+    std::string Send(http::verb method, std::string_view target, std::string body = {}) {
+        StringRequest req{method, target, 11};
+        if (!authorization_.empty()) {
+            req.set(http::field::authorization, authorization_);
+        }
+        if (method == http::verb::post) {
+            req.set(http::field::content_type, "application/json");
+            req.body() = std::move(body);
+            req.prepare_payload();
+        }
+
+        std::optional<std::string> response;
+        const api_router::RouteMatch match = api_router::Match(req.target());
+        handler_.HandleRequest(std::move(req), [&response](auto&& res) {
+            response = BodyText(res);
+        }, match);
+        ioc_.restart();
+        ioc_.run();
+        REQUIRE(response);
+        return *response;
+    }
+
+    void SetToken(const std::string& token) {
+        authorization_ = "Bearer " + token;
+    }
+
+private:
+    http_handler::ApiRequestHandler& handler_;
+    net::io_context& ioc_;
+    std::string authorization_;
+};
+
+json::array DogSpeed(const std::string& state, int64_t dog_id) {
+    return json::parse(state).as_object().at("players").as_object().at(std::to_string(dog_id)).as_object().at("speed").as_array();
+}
+
+}  // namespace
+
+SCENARIO("Game state reflects a player's action before the next tick") {
+    GIVEN("a player who has already read the cached state") {
+        model::Game game;
+        model::Map map{model::Map::Id{"map1"s}, "Map 1"s};
+        map.AddRoad(model::Road{model::Road::HORIZONTAL, {0, 0}, 40});
+        map.AddRoad(model::Road{model::Road::VERTICAL, {0, 0}, 40});
+        map.SetSpeedForThisMap(2.0);
+        map.SetLootTypes({{10, 1}});
+        map.SetLootGenerator(loot_gen::LootGenerator{1s, 0.0});
+        game.AddMap(std::move(map));
+
+        net::io_context ioc;
+        http_handler::ApiRequestHandler handler{game, net::make_strand(ioc), false, std::nullopt, std::nullopt, nullptr};
+        ApiClient client{handler, ioc};
+
+        const auto joined = json::parse(
+            client.Send(http::verb::post, "/api/v1/game/join"sv, R"({"userName":"dog","mapId":"map1"})")).as_object();
+        const std::string token{joined.at("authToken").as_string().c_str()};
+        const int64_t dog_id = joined.at("playerId").to_number<int64_t>();
+        client.SetToken(token);
+
+        // Тик публикует игрока для чтения вне strand, первое чтение собирает снимок
+        client.Send(http::verb::post, "/api/v1/game/tick"sv, R"({"timeDelta":0})");
+        REQUIRE(DogSpeed(client.Send(http::verb::get, "/api/v1/game/state"sv), dog_id) == json::array{0.0, 0.0});
+        REQUIRE(DogSpeed(client.Send(http::verb::get, "/api/v1/game/state"sv), dog_id) == json::array{0.0, 0.0});
+
+        WHEN("the player steers the dog") {
+            client.Send(http::verb::post, "/api/v1/game/player/action"sv, R"({"move":"R"})");
+            THEN("the next state read shows the new speed") {
+                CHECK(DogSpeed(client.Send(http::verb::get, "/api/v1/game/state"sv), dog_id) == json::array{2.0, 0.0});
+            }
+        }
+
+        WHEN("the player steers the dog with a batch action") {
+            client.Send(http::verb::post, "/api/v1/game/player/actions"sv,
+                        R"([{"token":")" + token + R"(","move":"D"}])");
+            THEN("the next state read shows the new speed") {
+                CHECK(DogSpeed(client.Send(http::verb::get, "/api/v1/game/state"sv), dog_id) == json::array{0.0, 2.0});
+            }
+        }
+    }
+}
@@ -0,0 +1,135 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/objects.h"
+
+using namespace std::literals;
+
+SCENARIO("Idle dogs retire after the map retirement time") {
+    using model::Map;
+    using model::Road;
+
+    GIVEN("a session on a map with 10 second retirement time") {
+        Map map{Map::Id{"map1"s}, "Map 1"s};
+        map.AddRoad(Road{Road::HORIZONTAL, {0, 0}, 100});
+        map.SetRetirementTime(10.0);
+        GameSession session{&map};
+
+        auto idle = session.AddDog("idle"s);
+        auto runner = session.AddDog("runner"s);
+        session.SteerDog(runner, Direction::EAST, 1.0);
+
+        WHEN("less time than the retirement time passes") {
+            for (int i = 0; i < 99; ++i) {
+                session.MoveDogs(100);
+            }
+            THEN("nobody retires") {
+                CHECK(session.GetRetiredDogs().empty());
+                CHECK_FALSE(idle->IsRetired());
+            }
+        }
+
+        WHEN("the retirement time passes in small ticks") {
+            for (int i = 0; i < 100; ++i) {
+                session.MoveDogs(100);
+            }
+            THEN("only the standing dog retires") {
+                REQUIRE(session.GetRetiredDogs().size() == 1);
+                CHECK(session.GetRetiredDogs().front() == idle);
+                CHECK(idle->IsRetired());
+                CHECK_FALSE(runner->IsRetired());
+            }
+        }
+
+        WHEN("the retirement time passes in one long tick") {
+            session.MoveDogs(60'000);
+            THEN("the standing dog retires") {
+                REQUIRE(session.GetRetiredDogs().size() == 1);
+                CHECK(session.GetRetiredDogs().front() == idle);
+            }
+        }
+
+        WHEN("the standing dog starts moving before its deadline") {
+            session.MoveDogs(6'000);
+            session.SteerDog(idle, Direction::EAST, 1.0);
+            session.MoveDogs(6'000);
+            THEN("it does not retire") {
+                CHECK(session.GetRetiredDogs().empty());
+            }
+
+            AND_WHEN("both dogs get stuck at the road end") {
+                session.MoveDogs(200'000);
+                THEN("they retire as idle dogs") {
+                    CHECK(idle->IsRetired());
+                    CHECK(runner->IsRetired());
+                }
+            }
+        }
+
+        WHEN("a retired dog is removed from the session") {
+            session.MoveDogs(10'000);
+            session.RemoveDog(idle->GetId());
+            session.ClearRetiredDogs();
+            THEN("the session keeps working") {
+                session.MoveDogs(10'000);
+                CHECK(session.GetDogs().size() == 1);
+            }
+        }
+    }
+}
+
+SCENARIO("A tick removes only the players whose dogs retired") {
+    using model::Map;
+    using model::Road;
+
+    GIVEN("two players on a map with 10 second retirement time") {
+        Map map{Map::Id{"map1"s}, "Map 1"s};
+        map.AddRoad(Road{Road::HORIZONTAL, {0, 0}, 100});
+        map.SetRetirementTime(10.0);
+        auto session = std::make_shared<GameSession>(&map);
+        Players players;
+
+        auto idle = session->AddDog("idle"s);
+        auto runner = session->AddDog("runner"s);
+        players.AddPlayer(session, idle);
+        const Token runner_token = players.AddPlayer(session, runner).GetToken();
+        session->SteerDog(runner, Direction::EAST, 1.0);
+
+        std::vector<std::string> recorded;
+        auto record = [&recorded](const Dog &dog) {
+            recorded.emplace_back(dog.GetName());
+        };
+
+        WHEN("a tick passes before anyone retires") {
+            session->MoveDogs(100);
+            const size_t removed = players.RemoveRetired(*session, record);
+            THEN("every player stays in the game") {
+                CHECK(removed == 0);
+                CHECK(players.GetPlayerCount() == 2);
+                CHECK(recorded.empty());
+            }
+        }
+
+        WHEN("the standing dog retires") {
+            session->MoveDogs(10'000);
+            const size_t removed = players.RemoveRetired(*session, record);
+            THEN("only its player leaves and its result is recorded once") {
+                CHECK(removed == 1);
+                REQUIRE(players.GetPlayerCount() == 1);
+                CHECK(players.FindByToken(runner_token) != nullptr);
+                CHECK(players.FindByDog(idle.get()) == nullptr);
+                CHECK(recorded == std::vector<std::string>{"idle"s});
+                CHECK(session->GetDogs().size() == 1);
+                CHECK(session->GetRetiredDogs().empty());
+            }
+
+            AND_WHEN("the next tick passes") {
+                session->MoveDogs(100);
+                players.RemoveRetired(*session, record);
+                THEN("the remaining player is kept") {
+                    CHECK(players.GetPlayerCount() == 1);
+                    CHECK(recorded.size() == 1);
+                }
+            }
+        }
+    }
+}
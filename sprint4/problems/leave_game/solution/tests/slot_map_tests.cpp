@@ -0,0 +1,66 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/slot_map.h"
+
+#include <algorithm>
+#include <vector>
+
+SCENARIO("Slot map keeps handles stable across removals") {
+    using util::SlotMap;
+
+    GIVEN("a slot map with several values") {
+        SlotMap<int> values;
+        std::vector<SlotMap<int>::Handle> handles;
+        for (int i = 0; i < 5; ++i) {
+            handles.push_back(values.Insert(i * 10));
+        }
+
+        THEN("values are found by their handles") {
+            REQUIRE(values.size() == 5);
+            for (int i = 0; i < 5; ++i) {
+                REQUIRE(values.Find(handles[i]) != nullptr);
+                CHECK(*values.Find(handles[i]) == i * 10);
+            }
+        }
+
+        WHEN("a value in the middle is erased") {
+            REQUIRE(values.Erase(handles[1]));
+
+            THEN("it is no longer found and cannot be erased twice") {
+                CHECK(values.Find(handles[1]) == nullptr);
+                CHECK_FALSE(values.Erase(handles[1]));
+            }
+            THEN("other handles still point to their values") {
+                CHECK(values.size() == 4);
+                for (int i : {0, 2, 3, 4}) {
+                    REQUIRE(values.Find(handles[i]) != nullptr);
+                    CHECK(*values.Find(handles[i]) == i * 10);
+                }
+            }
+            THEN("values stay dense") {
+                std::vector<int> dense(values.begin(), values.end());
+                std::sort(dense.begin(), dense.end());
+                CHECK(dense == std::vector<int>{0, 20, 30, 40});
+            }
+
+            AND_WHEN("a new value reuses the freed slot") {
+                const auto handle = values.Insert(100);
+
+                THEN("the stale handle does not see it") {
+                    CHECK(handle.index == handles[1].index);
+                    CHECK(values.Find(handles[1]) == nullptr);
+                    REQUIRE(values.Find(handle) != nullptr);
+                    CHECK(*values.Find(handle) == 100);
+                }
+            }
+        }
+
+        WHEN("handles are taken by position") {
+            THEN("they match the values at those positions") {
+                for (size_t i = 0; i < values.size(); ++i) {
+                    CHECK(values.Find(values.GetHandle(i)) == &*(values.begin() + i));
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,100 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/objects.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+using namespace std::literals;
+
+namespace {
+
+// Счётчик обращений к куче, включаемый только на время замера
+std::atomic<bool> count_allocations{false};
+std::atomic<size_t> allocation_count{0};
+
+}  // namespace
+
+void* operator new(std::size_t size) {
+    if (count_allocations.load(std::memory_order_relaxed)) {
+        allocation_count.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (void* ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+SCENARIO("Steady-state tick does not touch the heap") {
+    using model::Map;
+    using model::Road;
+
+    GIVEN("a session with moving dogs and spawning loot") {
+        Map map{Map::Id{"map1"s}, "Map 1"s};
+        map.AddRoad(Road{Road::HORIZONTAL, {0, 0}, 40});
+        map.AddRoad(Road{Road::VERTICAL, {40, 0}, 40});
+        map.AddOffice(model::Office{model::Office::Id{"o1"s}, {20, 0}, {0, 0}});
+        map.AddOffice(model::Office{model::Office::Id{"o2"s}, {40, 20}, {0, 0}});
+        map.SetLootTypes({{10, 1}, {20, 1}});
+        map.SetLootGenerator(loot_gen::LootGenerator{1s, 1.0});
+        map.SetRetirementTime(30.0);
+
+        GameSession session{&map};
+        constexpr int DOG_COUNT = 50;
+        for (int i = 0; i < DOG_COUNT; ++i) {
+            auto dog = session.AddDog("dog"s + std::to_string(i), true);
+            dog->SetBagCapacityForDog(3);
+        }
+
+        constexpr auto TICK = 50ms;
+        // Собаки ходят из конца в конец дороги, проходя через офисы
+        const Direction forward[] = {Direction::EAST, Direction::SOUTH};
+        const Direction backward[] = {Direction::WEST, Direction::NORTH};
+        auto run_ticks = [&](int count, int& tick) {
+            for (int i = 0; i < count; ++i, ++tick) {
+                if (tick % 300 == 0) {
+                    const auto& directions = (tick / 300) % 2 == 0 ? forward : backward;
+                    for (const auto& dog : session.GetDogs()) {
+                        session.SteerDog(dog, directions[dog->GetId() % 2], 3.0);
+                    }
+                }
+                session.MoveDogs(static_cast<int>(TICK.count()));
+                session.GatherLoot();
+                session.SpawnLoot(TICK);
+            }
+        };
+
+        int tick = 0;
+        run_ticks(2000, tick);
+
+        auto total_score = [&] {
+            int score = 0;
+            for (const auto& dog : session.GetDogs()) {
+                score += dog->GetScore();
+            }
+            return score;
+        };
+
+        WHEN("more ticks are simulated after warm-up") {
+            const int score_before = total_score();
+            allocation_count = 0;
+            count_allocations = true;
+            run_ticks(500, tick);
+            count_allocations = false;
+
+            THEN("loot is still gathered, but no heap allocations were made") {
+                CHECK(total_score() > score_before);
+                CHECK(allocation_count == 0);
+            }
+        }
+    }
+}
@@ -0,0 +1,72 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/timer_wheel.h"
+
+#include <algorithm>
+#include <random>
+#include <utility>
+#include <vector>
+
+SCENARIO("Timer wheel fires timers when their deadline is reached") {
+    using util::TimerWheel;
+
+    GIVEN("a timer wheel with timers at different distances") {
+        TimerWheel<int> wheel{1000};
+        wheel.Schedule(1001, 1);
+        wheel.Schedule(1064, 2);
+        wheel.Schedule(5000, 3);
+        wheel.Schedule(1000 + (uint64_t{1} << 30), 4);
+        wheel.Schedule(900, 5);
+
+        std::vector<std::pair<int, uint64_t>> fired;
+        auto record = [&fired](int value, uint64_t deadline) {
+            fired.emplace_back(value, deadline);
+        };
+
+        WHEN("time advances by one millisecond") {
+            wheel.Advance(1001, record);
+            THEN("overdue and due timers fire") {
+                CHECK(fired == std::vector<std::pair<int, uint64_t>>{{5, 900}, {1, 1001}});
+                CHECK(wheel.size() == 3);
+            }
+        }
+
+        WHEN("time advances past every deadline in one step") {
+            wheel.Advance(uint64_t{1} << 40, record);
+            THEN("all timers fire in deadline order") {
+                CHECK(fired == std::vector<std::pair<int, uint64_t>>{
+                                   {5, 900}, {1, 1001}, {2, 1064}, {3, 5000}, {4, 1000 + (uint64_t{1} << 30)}});
+                CHECK(wheel.size() == 0);
+                CHECK(wheel.GetTime() == uint64_t{1} << 40);
+            }
+        }
+    }
+
+    GIVEN("many random timers advanced with random steps") {
+        TimerWheel<size_t> wheel;
+        std::mt19937_64 random{42};
+        std::vector<uint64_t> deadlines;
+        for (size_t i = 0; i < 5000; ++i) {
+            deadlines.push_back(1 + random() % 20'000'000);
+            wheel.Schedule(deadlines.back(), i);
+        }
+
+        THEN("each timer fires exactly once, not before its deadline and not after the step that reached it") {
+            std::vector<int> fire_count(deadlines.size(), 0);
+            uint64_t now = 0;
+            while (wheel.size() > 0) {
+                const uint64_t prev = now;
+                now += random() % 100'000;
+                wheel.Advance(now, [&](size_t idx, uint64_t deadline) {
+                    REQUIRE(deadline == deadlines[idx]);
+                    REQUIRE(deadline <= now);
+                    REQUIRE(deadline > prev);
+                    ++fire_count[idx];
+                });
+            }
+            CHECK(std::all_of(fire_count.begin(), fire_count.end(), [](int count) {
+                return count == 1;
+            }));
+        }
+    }
+}
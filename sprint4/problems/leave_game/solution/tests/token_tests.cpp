@@ -0,0 +1,43 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/token.h"
+
+#include <algorithm>
+#include <cctype>
+
+using namespace std::literals;
+
+SCENARIO("Tokens round-trip through their lowercase hex form") {
+    GIVEN("a generated token") {
+        const Token token = Token::Generate();
+        const std::string hex = token.ToHex();
+
+        THEN("its hex form parses back to the same token") {
+            REQUIRE(hex.size() == Token::HEX_SIZE);
+            const auto parsed = Token::FromHex(hex);
+            REQUIRE(parsed);
+            CHECK(*parsed == token);
+        }
+
+        WHEN("the hex form is spelled in upper case") {
+            std::string upper = hex;
+            std::transform(upper.begin(), upper.end(), upper.begin(), [](unsigned char c) {
+                return static_cast<char>(std::toupper(c));
+            });
+            THEN("it is rejected unless it has no letters") {
+                const bool has_letters = upper != hex;
+                CHECK(Token::FromHex(upper).has_value() == !has_letters);
+            }
+        }
+    }
+
+    GIVEN("malformed strings") {
+        THEN("they are rejected") {
+            CHECK_FALSE(Token::FromHex(""sv));
+            CHECK_FALSE(Token::FromHex("0123456789abcdef0123456789abcde"sv));
+            CHECK_FALSE(Token::FromHex("0123456789abcdef0123456789abcdeg"sv));
+            CHECK_FALSE(Token::FromHex("0123456789ABCDEF0123456789abcdef"sv));
+            CHECK(Token::FromHex("0123456789abcdef0123456789abcdef"sv));
+        }
+    }
+}